@@ -0,0 +1,109 @@
+#ifndef LOADERS_LOAD_PROGRESS_H
+#define LOADERS_LOAD_PROGRESS_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace s21 {
+/**
+ * @struct MeshExtent
+ * @brief Какие элементы массивов меша уже записаны загрузчиком.
+ *
+ * Файловые нормали/UV лежат в начале массивов, сгенерированные — отдельным
+ * участком следом, поэтому у них по два диапазона.
+ */
+struct MeshExtent {
+  uint32_t vertices = 0;         ///< Вершины [0, vertices).
+  uint32_t normals = 0;          ///< Нормали из файла [0, normals).
+  uint32_t genNormalsBegin = 0;  ///< Начало сгенерированных нормалей.
+  uint32_t genNormals = 0;  ///< Сгенерированные [genNormalsBegin, genNormals).
+  uint32_t uvs = 0;         ///< UV из файла [0, uvs).
+  uint32_t genUvsBegin = 0;  ///< Начало сгенерированных UV.
+  uint32_t genUvs = 0;       ///< Сгенерированные [genUvsBegin, genUvs).
+  uint32_t faces = 0;        ///< Грани [0, faces).
+};
+
+/**
+ * @struct LoadProgress
+ * @brief Прогресс фоновой загрузки: загрузчик пишет, GUI читает.
+ *
+ * Счётчики атомарные, блокировок нет. Загрузчик обновляет их и проверяет
+ * cancelled примерно раз на мегабайт текста.
+ *
+ * Если задан publishStep, загрузчик размечает массивы меша один раз и раз в
+ * publishStep треугольников публикует записанную часть (publish). Читатель
+ * после published() может читать эти участки меша из другого потока: до
+ * конца загрузки они не меняются и не переезжают.
+ */
+struct LoadProgress {
+  /** Сколько байт текста пройдёт загрузчик (параллельный разбор читает файл
+   *  несколькими проходами — каждый входит сюда). */
+  std::atomic<uint64_t> totalBytes{0};
+  std::atomic<uint64_t> fileBytes{0};    ///< Размер файла.
+  std::atomic<uint64_t> bytesParsed{0};  ///< Уже пройдено байт.
+  std::atomic<uint64_t> facesBuilt{0};   ///< Построено треугольников.
+  std::atomic<bool> cancelled{false};    ///< Запрошена отмена.
+  /** Разбор больше не нужен: меш уже взят из кеша. Загрузчик выходит, как
+   *  при отмене, но это не отмена загрузки. */
+  std::atomic<bool> superseded{false};
+  /** Поток загрузки закончил всю работу, включая запись кеша. */
+  std::atomic<bool> finished{false};
+  uint32_t publishStep = 0;  ///< Шаг публикации в треугольниках; 0 — нет.
+
+  /** @brief Просит загрузчик остановиться как можно скорее. */
+  void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+  /** @brief Запрошена ли отмена. */
+  bool isCancelled() const {
+    return cancelled.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Пора ли загрузчику бросить разбор: отмена или кеш. */
+  bool stopParsing() const {
+    return isCancelled() || superseded.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Открывает читателю записанную часть меша (зовёт загрузчик). */
+  void publish(const MeshExtent& extent) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    publishedExtent = extent;
+  }
+
+  /** @brief Последняя опубликованная часть меша (пустая, если её нет). */
+  MeshExtent published() const {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    return publishedExtent;
+  }
+
+ private:
+  mutable std::mutex publishMutex;  ///< Публикация — раз в publishStep граней.
+  MeshExtent publishedExtent;       ///< Что уже можно читать.
+};
+
+/**
+ * @struct LoadStatus
+ * @brief Снимок состояния фоновой загрузки для интерфейса.
+ */
+struct LoadStatus {
+  bool loading = false;      ///< Загрузка идёт.
+  uint64_t totalBytes = 0;   ///< См. LoadProgress::totalBytes.
+  uint64_t fileBytes = 0;    ///< Размер файла.
+  uint64_t bytesParsed = 0;  ///< Пройдено байт.
+  uint64_t facesBuilt = 0;   ///< Построено треугольников.
+  std::string error;  ///< Ошибка последней загрузки (пусто, если её не было).
+
+  /** @brief Сколько байт файла пройдено: проходы разбора пересчитаны в
+   *  долю файла. */
+  uint64_t fileBytesParsed() const {
+    if (totalBytes == 0) return 0;
+    return static_cast<uint64_t>(static_cast<double>(bytesParsed) *
+                                 fileBytes / totalBytes);
+  }
+};
+
+/** Шаг, с которым загрузчик отчитывается и проверяет отмену. */
+constexpr uint64_t kProgressStepBytes = 1u << 20;
+}  // namespace s21
+#endif  // LOADERS_LOAD_PROGRESS_H
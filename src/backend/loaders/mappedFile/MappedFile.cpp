@@ -0,0 +1,62 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace s21 {
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    close();
+    fd_ = std::exchange(other.fd_, -1);
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+bool MappedFile::open(const std::string& filepath) {
+  close();
+
+  int fd = ::open(filepath.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+
+  fd_ = fd;
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ == 0) return true;  // mmap нулевой длины не бывает
+
+  void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (addr == MAP_FAILED) {
+    close();
+    return false;
+  }
+  // Файл читается один раз от начала до конца — просим ядро читать вперёд.
+  ::madvise(addr, size_, MADV_SEQUENTIAL);
+  data_ = static_cast<const char*>(addr);
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_) ::munmap(const_cast<char*>(data_), size_);
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+  data_ = nullptr;
+  size_ = 0;
+}
+}  // namespace s21
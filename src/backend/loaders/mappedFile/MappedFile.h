@@ -0,0 +1,52 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace s21 {
+/**
+ * @class MappedFile
+ * @brief Файл, отображённый в память только для чтения (mmap).
+ *
+ * Лоадеры разбирают содержимое прямо по указателю, без копий в строки и
+ * потоки. Отображение снимается в деструкторе.
+ */
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  /**
+   * @brief Отображает файл в память.
+   * @param filepath Путь к файлу.
+   * @return true, если файл открыт (пустой файл — тоже успех, size() == 0).
+   */
+  bool open(const std::string& filepath);
+
+  /**
+   * @brief Снимает отображение и закрывает файл.
+   */
+  void close();
+
+  /** @brief Открыт ли файл. */
+  bool isOpen() const { return fd_ >= 0; }
+
+  /** @brief Начало данных (nullptr для пустого файла). */
+  const char* data() const { return data_; }
+
+  /** @brief Размер файла в байтах. */
+  size_t size() const { return size_; }
+
+ private:
+  int fd_ = -1;                ///< Дескриптор открытого файла.
+  const char* data_ = nullptr;  ///< Начало отображения.
+  size_t size_ = 0;            ///< Размер отображения.
+};
+}  // namespace s21
+#endif  // MAPPED_FILE_H
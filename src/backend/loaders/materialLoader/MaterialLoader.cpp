@@ -8,7 +8,10 @@
 
 namespace s21 {
 void MtlFileLoader::loadMtl(const std::string& filepath,
-                            MaterialManager& materialManager) {
+                            MaterialManager& materialManager,
+                            std::vector<std::string>* dependencies) {
+  if (dependencies) dependencies->push_back(filepath);
+
   std::ifstream file(filepath);
   if (!file.is_open()) {
     std::cerr << "Could not open material file " << filepath << "\n";
@@ -47,6 +50,7 @@ void MtlFileLoader::loadMtl(const std::string& filepath,
       std::filesystem::path dirPath = mtlPath.parent_path();
 
       std::string textureKdPath = resolveAssetPath(dirPath, textureKdName);
+      if (dependencies) dependencies->push_back(textureKdPath);
 
       Texture texture = TextureLoader::loadTexture(textureKdPath);
       material.texture = texture;
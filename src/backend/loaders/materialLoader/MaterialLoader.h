@@ -2,6 +2,7 @@
 #define MATERIALLOADER_H
 
 #include <string>
+#include <vector>
 
 #include "backend/material_manager/material_manager.h"
 
@@ -16,9 +17,12 @@ class MtlFileLoader {
    * @brief Загружает файл .mtl и добавляет материалы в MaterialManager.
    * @param filepath Путь к файлу .mtl.
    * @param materialManager Менеджер материалов, в который загружаются данные.
+   * @param dependencies Если задан, сюда дописываются путь к .mtl и пути
+   * текстур (даже отсутствующих — их появление тоже меняет результат).
    */
   static void loadMtl(const std::string& filepath,
-                      MaterialManager& materialManager);
+                      MaterialManager& materialManager,
+                      std::vector<std::string>* dependencies = nullptr);
 
  private:
   /**
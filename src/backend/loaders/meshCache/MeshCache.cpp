@@ -0,0 +1,467 @@
+#include "MeshCache.h"
+
+#include <omp.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "backend/loaders/mappedFile/MappedFile.h"
+
+namespace s21 {
+namespace {
+constexpr char kMagic[8] = {'S', '2', '1', 'M', 'E', 'S', 'H', '\0'};
+// Поднимать при любом изменении раскладки: старые файлы просто не читаются.
+constexpr uint32_t kVersion = 4;
+constexpr uint64_t kAlign = 64;  // выравнивание секций (кеш-линия)
+constexpr size_t kHashBlock = 4u << 20;  // кусок параллельного хеширования
+
+enum Section : uint32_t {
+  kVertices,
+  kNormals,
+  kUvs,
+  kFaces,
+  kPlanes,
+  kTexels,
+  kMaterials,
+  kDependencies,
+  kStrings,
+  kSectionCount
+};
+
+struct SectionRange {
+  uint64_t offset;  ///< Смещение от начала файла (кратно kAlign).
+  uint64_t bytes;   ///< Размер секции.
+};
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerBytes;
+  uint32_t elementBytes[kSectionCount];  ///< Защита от чужой раскладки типов.
+  uint32_t firstMaterial;  ///< id первого своего материала при записи.
+  uint64_t sourceHash;     ///< Хеш .obj — ключ кеша.
+  uint64_t fileBytes;      ///< Полный размер файла (ловит обрезку).
+  uint64_t payloadHash;    ///< Хеш всех секций (ловит порчу).
+  SectionRange sections[kSectionCount];
+};
+
+struct MaterialRecord {
+  float ambient[3];
+  float diffuse[3];
+  float specular[3];
+  float shininess;
+  uint32_t nameOffset;  ///< В секции строк.
+  uint32_t nameBytes;
+  int32_t width;
+  int32_t height;
+  uint64_t texelOffset;  ///< В элементах секции текселей.
+  uint64_t texelCount;
+};
+
+struct DependencyRecord {
+  uint64_t hash;  ///< hashFile на момент записи (0 — файла не было).
+  uint64_t pathOffset;
+  uint64_t pathBytes;
+};
+
+constexpr uint32_t kElementBytes[kSectionCount] = {
+    sizeof(Vertex),         sizeof(Normal),         sizeof(UVCoordinate),
+    sizeof(Face),           sizeof(Plane),          sizeof(Texel),
+    sizeof(MaterialRecord), sizeof(DependencyRecord), 1};
+
+uint64_t alignUp(uint64_t value) { return (value + kAlign - 1) / kAlign * kAlign; }
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t finalize(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// Четыре независимые дорожки по 8 байт: умножения не ждут друг друга.
+uint64_t hashBlock(const char* p, size_t n, uint64_t seed) {
+  constexpr uint64_t k1 = 0x9E3779B97F4A7C15ULL;
+  constexpr uint64_t k2 = 0xbf58476d1ce4e5b9ULL;
+  uint64_t lane[4] = {seed ^ k1, seed ^ k2, seed + k1, seed - k2};
+
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    for (int l = 0; l < 4; ++l) {
+      uint64_t w;
+      std::memcpy(&w, p + i + 8 * l, 8);
+      lane[l] = rotl(lane[l] ^ (w * k1), 31) * k2;
+    }
+  }
+  uint64_t h = n * k1;
+  for (int l = 0; l < 4; ++l) h = rotl(h ^ finalize(lane[l]), 27) * k2;
+  for (; i < n; i += 8) {
+    uint64_t w = 0;
+    std::memcpy(&w, p + i, std::min<size_t>(8, n - i));
+    h = rotl(h ^ (w * k1), 31) * k2;
+  }
+  return finalize(h);
+}
+
+inline bool cancelled(const LoadProgress* progress) {
+  return progress && progress->isCancelled();
+}
+
+// Большие блоки хешируются кусками параллельно, хеши кусков — по порядку.
+// После отмены оставшиеся куски пропускаются, и хеш бессмыслен.
+uint64_t hashParallel(const char* data, size_t size,
+                      const LoadProgress* progress = nullptr) {
+  if (size <= kHashBlock) return hashBlock(data, size, 0);
+
+  const size_t blocks = (size + kHashBlock - 1) / kHashBlock;
+  std::vector<uint64_t> hashes(blocks);
+#pragma omp parallel for schedule(static)
+  for (long long b = 0; b < static_cast<long long>(blocks); ++b) {
+    if (cancelled(progress)) continue;
+    size_t offset = static_cast<size_t>(b) * kHashBlock;
+    hashes[b] = hashBlock(data + offset, std::min(kHashBlock, size - offset), b);
+  }
+  return hashBlock(reinterpret_cast<const char*>(hashes.data()),
+                   blocks * sizeof(uint64_t), size);
+}
+
+// Хеш всех секций по очереди; паддинг между ними не входит.
+uint64_t payloadHash(const char* base, const CacheHeader& header,
+                     const LoadProgress* progress = nullptr) {
+  uint64_t hashes[kSectionCount];
+  for (uint32_t s = 0; s < kSectionCount; ++s) {
+    hashes[s] = hashParallel(base + header.sections[s].offset,
+                             header.sections[s].bytes, progress);
+  }
+  return hashBlock(reinterpret_cast<const char*>(hashes), sizeof(hashes),
+                   kVersion);
+}
+
+template <typename T>
+const T* sectionData(const char* base, const CacheHeader& header, Section id) {
+  return reinterpret_cast<const T*>(base + header.sections[id].offset);
+}
+
+template <typename T>
+size_t sectionCount(const CacheHeader& header, Section id) {
+  return header.sections[id].bytes / sizeof(T);
+}
+}  // namespace
+
+uint64_t MeshCache::hashBytes(const char* data, size_t size,
+                              const LoadProgress* progress) {
+  return hashParallel(data, size, progress);
+}
+
+uint64_t MeshCache::hashFile(const std::string& filepath,
+                             const LoadProgress* progress) {
+  MappedFile file;
+  if (!file.open(filepath)) return 0;
+  uint64_t hash = hashBytes(file.data(), file.size(), progress);
+  if (cancelled(progress)) return 0;
+  return hash ? hash : 1;  // 0 занят под «файла нет»
+}
+
+std::string MeshCache::cachePath(uint64_t sourceHash) {
+  namespace fs = std::filesystem;
+  fs::path dir;
+  if (const char* own = std::getenv("S21_CACHE_DIR")) {
+    if (std::string(own) == "off") return {};
+    dir = own;
+  } else if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    dir = fs::path(xdg) / "3dviewer";
+  } else if (const char* home = std::getenv("HOME"); home && *home) {
+    dir = fs::path(home) / ".cache" / "3dviewer";
+  } else {
+    dir = fs::temp_directory_path() / "3dviewer";
+  }
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.mesh",
+                static_cast<unsigned long long>(sourceHash));
+  return (dir / name).string();
+}
+
+bool MeshCache::load(uint64_t sourceHash, Mesh& mesh,
+                     MaterialManager& materialManager) {
+  std::string path = cachePath(sourceHash);
+  if (path.empty() || sourceHash == 0) return false;
+
+  auto file = std::make_shared<MappedFile>();
+  if (!file->open(path)) return false;  // промах — не ошибка
+
+  auto reject = [&path](const char* why) {
+    std::cerr << "Mesh cache " << path << " ignored: " << why << "\n";
+    return false;
+  };
+
+  // --- Проверки до любых изменений в mesh и materialManager ---------------
+  const char* base = file->data();
+  const uint64_t fileBytes = file->size();
+  CacheHeader header;
+  if (fileBytes < sizeof(header)) return reject("truncated");
+  std::memcpy(&header, base, sizeof(header));
+
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.headerBytes != sizeof(header) ||
+      std::memcmp(header.elementBytes, kElementBytes, sizeof(kElementBytes))) {
+    return reject("other format version");
+  }
+  if (header.sourceHash != sourceHash) return reject("key mismatch");
+  if (header.fileBytes != fileBytes) return reject("truncated");
+  for (uint32_t s = 0; s < kSectionCount; ++s) {
+    const SectionRange& range = header.sections[s];
+    if (range.offset % kAlign != 0 || range.offset < sizeof(header) ||
+        range.offset > fileBytes || range.bytes > fileBytes - range.offset ||
+        range.bytes % kElementBytes[s] != 0) {
+      return reject("bad section table");
+    }
+  }
+  // Плоскости граней пишутся для каждой грани или не пишутся вовсе.
+  const size_t planeCount = sectionCount<Plane>(header, kPlanes);
+  if (planeCount != 0 && planeCount != sectionCount<Face>(header, kFaces)) {
+    return reject("bad section table");
+  }
+  if (payloadHash(base, header) != header.payloadHash) {
+    return reject("checksum mismatch");
+  }
+
+  const char* strings = sectionData<char>(base, header, kStrings);
+  const uint64_t stringBytes = header.sections[kStrings].bytes;
+  const size_t texelCount = sectionCount<Texel>(header, kTexels);
+
+  const auto* materials = sectionData<MaterialRecord>(base, header, kMaterials);
+  const size_t materialCount = sectionCount<MaterialRecord>(header, kMaterials);
+  for (size_t i = 0; i < materialCount; ++i) {
+    const MaterialRecord& rec = materials[i];
+    bool badTexture =
+        rec.texelCount != 0 &&
+        (rec.width <= 0 || rec.height <= 0 ||
+         rec.texelCount != Texture::mipTexels(rec.width, rec.height));
+    if (rec.nameBytes > stringBytes ||
+        rec.nameOffset > stringBytes - rec.nameBytes ||
+        rec.texelOffset > texelCount ||
+        rec.texelCount > texelCount - rec.texelOffset || badTexture) {
+      return reject("bad material table");
+    }
+  }
+
+  const auto* dependencies =
+      sectionData<DependencyRecord>(base, header, kDependencies);
+  const size_t dependencyCount =
+      sectionCount<DependencyRecord>(header, kDependencies);
+  for (size_t i = 0; i < dependencyCount; ++i) {
+    const DependencyRecord& rec = dependencies[i];
+    if (rec.pathBytes > stringBytes ||
+        rec.pathOffset > stringBytes - rec.pathBytes) {
+      return reject("bad dependency table");
+    }
+    std::string dependency(strings + rec.pathOffset, rec.pathBytes);
+    if (hashFile(dependency) != rec.hash) {
+      return reject("source files changed");
+    }
+  }
+
+  // --- Кеш цел и свеж: массивы смотрят прямо в отображённый файл ----------
+  const uint32_t firstMaterial = materialManager.size();
+  const Texel* texels = sectionData<Texel>(base, header, kTexels);
+  for (size_t i = 0; i < materialCount; ++i) {
+    const MaterialRecord& rec = materials[i];
+    Material material;
+    material.ambient = Eigen::Vector3f(rec.ambient);
+    material.diffuse = Eigen::Vector3f(rec.diffuse);
+    material.specular = Eigen::Vector3f(rec.specular);
+    material.shininess = rec.shininess;
+    material.texture.width_ = rec.width;
+    material.texture.height_ = rec.height;
+    material.texture.colors_.adopt(texels + rec.texelOffset, rec.texelCount,
+                                   file);
+
+    std::string name(strings + rec.nameOffset, rec.nameBytes);
+    materialManager.addMaterial(name, material);
+  }
+
+  mesh.vertices_.adopt(sectionData<Vertex>(base, header, kVertices),
+                       sectionCount<Vertex>(header, kVertices), file);
+  mesh.normals_.adopt(sectionData<Normal>(base, header, kNormals),
+                      sectionCount<Normal>(header, kNormals), file);
+  mesh.uvCoordinates_.adopt(sectionData<UVCoordinate>(base, header, kUvs),
+                            sectionCount<UVCoordinate>(header, kUvs), file);
+  mesh.faces_.adopt(sectionData<Face>(base, header, kFaces),
+                    sectionCount<Face>(header, kFaces), file);
+  mesh.facePlanes_.adopt(sectionData<Plane>(base, header, kPlanes), planeCount,
+                         file);
+
+  // Материалы сцены уже могли занять другие id — тогда перенумеровываем
+  // (это единственный случай, когда грани копируются).
+  if (materialCount != 0) {
+    mesh.remapMaterials(header.firstMaterial, firstMaterial);
+  }
+  return true;
+}
+
+void MeshCache::store(uint64_t sourceHash, const Mesh& mesh,
+                      const MaterialManager& materialManager,
+                      uint32_t firstMaterial,
+                      const std::vector<std::string>& dependencies,
+                      const LoadProgress* progress) {
+  namespace fs = std::filesystem;
+  std::string path = cachePath(sourceHash);
+  if (path.empty() || sourceHash == 0 || cancelled(progress)) return;
+
+  // Грань с материалом из прошлой загрузки по кешу не восстановить.
+  const Face* faces = mesh.faces_.data();
+  const long long faceCount = static_cast<long long>(mesh.faces_.size());
+  bool foreignMaterial = false;
+#pragma omp parallel for reduction(|| : foreignMaterial)
+  for (long long i = 0; i < faceCount; ++i) {
+    uint32_t index = faces[i].materialIndex;
+    foreignMaterial = foreignMaterial || (index != 0 && index < firstMaterial);
+  }
+  if (foreignMaterial) return;
+
+  // Маленькие таблицы собираем в памяти, большие массивы пишем как есть.
+  std::string strings;
+  std::vector<MaterialRecord> materials;
+  uint64_t texelCount = 0;
+  for (uint32_t id = firstMaterial; id < materialManager.size(); ++id) {
+    const Material& material = materialManager.getMaterial(id);
+    std::string name = materialManager.getMaterialName(id);
+
+    MaterialRecord rec{};
+    for (int k = 0; k < 3; ++k) {
+      rec.ambient[k] = material.ambient[k];
+      rec.diffuse[k] = material.diffuse[k];
+      rec.specular[k] = material.specular[k];
+    }
+    rec.shininess = material.shininess;
+    rec.nameOffset = static_cast<uint32_t>(strings.size());
+    rec.nameBytes = static_cast<uint32_t>(name.size());
+    rec.texelOffset = texelCount;
+    rec.texelCount = material.texture.colors_.size();
+    rec.width = rec.texelCount ? material.texture.width_ : 0;
+    rec.height = rec.texelCount ? material.texture.height_ : 0;
+    texelCount += rec.texelCount;
+    strings += name;
+    materials.push_back(rec);
+  }
+
+  std::vector<DependencyRecord> dependencyRecords;
+  for (const std::string& dependency : dependencies) {
+    std::error_code ec;
+    std::string absolute = fs::absolute(dependency, ec).string();
+    if (ec) absolute = dependency;
+    dependencyRecords.push_back(
+        {hashFile(absolute), strings.size(), absolute.size()});
+    strings += absolute;
+  }
+
+  std::error_code ec;
+  fs::create_directories(fs::path(path).parent_path(), ec);
+  // Отменённая запись может ещё идти, пока новая пишет тот же ключ, —
+  // временный файл у каждого потока свой.
+  std::string tmpPath =
+      path + ".tmp" + std::to_string(::getpid()) + "_" +
+      std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+  CacheHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.headerBytes = sizeof(header);
+  std::memcpy(header.elementBytes, kElementBytes, sizeof(kElementBytes));
+  header.firstMaterial = firstMaterial;
+  header.sourceHash = sourceHash;
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out) return;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint64_t position = sizeof(header);
+    auto beginSection = [&](Section id) {
+      static const char zeros[kAlign] = {};
+      uint64_t offset = alignUp(position);
+      out.write(zeros, static_cast<std::streamsize>(offset - position));
+      header.sections[id] = {offset, 0};
+      position = offset;
+    };
+    // Пишем кусками по kHashBlock, чтобы отмена не ждала всего массива.
+    auto append = [&](Section id, const void* data, uint64_t bytes) {
+      const char* bytesData = static_cast<const char*>(data);
+      for (uint64_t done = 0; done < bytes && !cancelled(progress);) {
+        const uint64_t piece = std::min<uint64_t>(kHashBlock, bytes - done);
+        out.write(bytesData + done, static_cast<std::streamsize>(piece));
+        done += piece;
+      }
+      header.sections[id].bytes += bytes;
+      position += bytes;
+    };
+    auto section = [&](Section id, const void* data, uint64_t bytes) {
+      beginSection(id);
+      append(id, data, bytes);
+    };
+
+    section(kVertices, mesh.vertices_.data(),
+            mesh.vertices_.size() * sizeof(Vertex));
+    section(kNormals, mesh.normals_.data(),
+            mesh.normals_.size() * sizeof(Normal));
+    section(kUvs, mesh.uvCoordinates_.data(),
+            mesh.uvCoordinates_.size() * sizeof(UVCoordinate));
+    section(kFaces, faces, mesh.faces_.size() * sizeof(Face));
+    // Плоскости не досчитаны — секция пустая, их посчитает загрузка.
+    const bool planes = mesh.facePlanes_.size() == mesh.faces_.size();
+    section(kPlanes, mesh.facePlanes_.data(),
+            planes ? mesh.facePlanes_.size() * sizeof(Plane) : 0);
+    beginSection(kTexels);
+    for (uint32_t id = firstMaterial; id < materialManager.size(); ++id) {
+      const auto& colors = materialManager.getMaterial(id).texture.colors_;
+      append(kTexels, colors.data(), colors.size() * sizeof(Texel));
+    }
+    section(kMaterials, materials.data(),
+            materials.size() * sizeof(MaterialRecord));
+    section(kDependencies, dependencyRecords.data(),
+            dependencyRecords.size() * sizeof(DependencyRecord));
+    section(kStrings, strings.data(), strings.size());
+    header.fileBytes = position;
+    if (!out || cancelled(progress)) {
+      fs::remove(tmpPath, ec);
+      return;
+    }
+  }
+
+  // Контрольную сумму считаем по записанному файлу — ровно так, как её
+  // будет проверять load().
+  {
+    MappedFile written;
+    if (!written.open(tmpPath) || written.size() != header.fileBytes) {
+      fs::remove(tmpPath, ec);
+      return;
+    }
+    header.payloadHash = payloadHash(written.data(), header, progress);
+  }
+  if (cancelled(progress)) {
+    fs::remove(tmpPath, ec);
+    return;
+  }
+  {
+    std::fstream patch(tmpPath, std::ios::binary | std::ios::in | std::ios::out);
+    patch.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!patch) {
+      fs::remove(tmpPath, ec);
+      return;
+    }
+  }
+  fs::rename(tmpPath, path, ec);
+  if (ec) fs::remove(tmpPath, ec);
+}
+}  // namespace s21
@@ -0,0 +1,91 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "backend/loaders/loadProgress.h"
+#include "backend/material_manager/material_manager.h"
+#include "backend/mesh/mesh.h"
+
+namespace s21 {
+/**
+ * @class MeshCache
+ * @brief Бинарный кеш готовых мешей на диске.
+ *
+ * Ключ — хеш содержимого .obj; внутри лежат массивы меша с плоскостями
+ * граней, таблица материалов, декодированные текстуры и хеши всех
+ * .mtl/текстур, от которых зависел результат. Секции выровнены по 64 байта,
+ * поэтому при загрузке файл отображается в память и массивы меша и текстур
+ * смотрят прямо в него.
+ *
+ * Каталог: $S21_CACHE_DIR, иначе $XDG_CACHE_HOME/3dviewer, иначе
+ * ~/.cache/3dviewer. S21_CACHE_DIR=off отключает кеш.
+ */
+class MeshCache {
+ public:
+  /**
+   * @brief Хеширует содержимое файла (некриптографический 64-битный хеш).
+   * @param filepath Путь к файлу.
+   * @param progress Флаг отмены (может быть null).
+   * @return Хеш или 0, если файл не открывается или загрузку отменили.
+   */
+  static uint64_t hashFile(const std::string& filepath,
+                           const LoadProgress* progress = nullptr);
+
+  /**
+   * @brief Загружает меш и его материалы из кеша.
+   *
+   * Ничего не меняет, если кеша нет, он от другой версии формата, повреждён
+   * или устарел (изменился .mtl или текстура): тогда вызывающий разбирает
+   * текст как обычно.
+   * @param sourceHash Хеш .obj (hashFile).
+   * @param mesh Меш, который станет видом на кеш.
+   * @param materialManager Менеджер, в который добавляются материалы.
+   * @return true, если меш загружен из кеша.
+   */
+  static bool load(uint64_t sourceHash, Mesh& mesh,
+                   MaterialManager& materialManager);
+
+  /**
+   * @brief Записывает разобранный меш в кеш (атомарно, через переименование).
+   * @param sourceHash Хеш .obj (hashFile).
+   * @param mesh Готовый меш; плоскости граней пишутся, если уже посчитаны.
+   * @param materialManager Менеджер материалов после загрузки.
+   * @param firstMaterial Первый id материала, добавленного этой загрузкой.
+   * @param dependencies Пути .mtl и текстур, прочитанных при загрузке.
+   * @param progress Флаг отмены (может быть null): после отмены запись
+   * бросается, временный файл удаляется.
+   */
+  static void store(uint64_t sourceHash, const Mesh& mesh,
+                    const MaterialManager& materialManager,
+                    uint32_t firstMaterial,
+                    const std::vector<std::string>& dependencies,
+                    const LoadProgress* progress = nullptr);
+
+ private:
+  /**
+   * @brief Закрытый конструктор, чтобы запретить создание экземпляров класса.
+   */
+  MeshCache(){};
+
+  /**
+   * @brief Путь к файлу кеша для ключа.
+   * @param sourceHash Хеш .obj.
+   * @return Путь или пустая строка, если кеш отключён.
+   */
+  static std::string cachePath(uint64_t sourceHash);
+
+  /**
+   * @brief Хеширует блок памяти; большие блоки — параллельно по кускам.
+   * @param data Начало данных.
+   * @param size Размер в байтах.
+   * @param progress Флаг отмены (может быть null).
+   * @return 64-битный хеш; после отмены бессмысленный.
+   */
+  static uint64_t hashBytes(const char* data, size_t size,
+                            const LoadProgress* progress);
+};
+}  // namespace s21
+#endif  // MESH_CACHE_H
@@ -1,129 +1,573 @@
 #include "backend/loaders/objectLoader/ObjectLoader.h"
 
+#include <omp.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
+#include <functional>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "backend/loaders/mappedFile/MappedFile.h"
 #include "backend/loaders/materialLoader/MaterialLoader.h"
 #include "backend/loaders/pathUtil.h"
 
 namespace s21 {
+namespace {
+// Пробел, таб и '\r' (CRLF-файлы из Windows) разделяют токены.
+inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline const char* lineEnd(const char* p, const char* end) {
+  const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+  return nl ? static_cast<const char*>(nl) : end;
+}
+
+inline const char* skipBlanks(const char* p, const char* end) {
+  while (p < end && isBlank(*p)) ++p;
+  return p;
+}
+
+// Следующий токен строки; p сдвигается за него.
+inline std::string_view readWord(const char*& p, const char* end) {
+  p = skipBlanks(p, end);
+  const char* start = p;
+  while (p < end && !isBlank(*p)) ++p;
+  return std::string_view(start, static_cast<size_t>(p - start));
+}
+
+// Файлы меньше этого грузим в один поток: на них запуск потоков и лишнее
+// копирование атрибутов съедают весь выигрыш.
+constexpr size_t kParallelMinBytes = 16u << 20;
+
+// Отчитывается о пройденном тексте раз в kProgressStepBytes и заодно
+// проверяет отмену. Без LoadProgress ничего не делает.
+class ProgressReporter {
+ public:
+  ProgressReporter(LoadProgress* progress, const char* start,
+                   uint32_t faces = 0)
+      : progress_(progress), reported_(start), reportedFaces_(faces) {}
+
+  // false — загрузку отменили, пора выходить.
+  bool update(const char* position, uint32_t faces) {
+    if (!progress_ ||
+        static_cast<uint64_t>(position - reported_) < kProgressStepBytes) {
+      return true;
+    }
+    flush(position, faces);
+    return !progress_->stopParsing();
+  }
+
+  void flush(const char* position, uint32_t faces) {
+    if (!progress_) return;
+    progress_->bytesParsed.fetch_add(
+        static_cast<uint64_t>(position - reported_), std::memory_order_relaxed);
+    progress_->facesBuilt.fetch_add(faces - reportedFaces_,
+                                    std::memory_order_relaxed);
+    reported_ = position;
+    reportedFaces_ = faces;
+  }
+
+ private:
+  LoadProgress* progress_;
+  const char* reported_;
+  uint32_t reportedFaces_;
+};
+
+inline bool stopped(const LoadProgress* progress) {
+  return progress && progress->stopParsing();
+}
+}  // namespace
+
+/**
+ * Кусок файла [begin, end), всегда по границам строк. Атрибуты складываются
+ * в локальные массивы; base — глобальные счётчики и позиции записи на начало
+ * куска, известные после префиксных сумм.
+ */
+struct ObjectLoader::ObjChunk {
+  const char* begin = nullptr;
+  const char* end = nullptr;
+
+  std::vector<Vertex> vertices;
+  std::vector<Normal> normals;
+  std::vector<UVCoordinate> uvs;
+
+  /** mtllib/usemtl в порядке появления; material заполняется при повторе. */
+  struct Event {
+    bool library;
+    std::string name;
+    uint32_t material;
+  };
+  std::vector<Event> events;
+
+  uint32_t startMaterial = 0;  ///< usemtl, действующий на начало куска.
+  ObjCounts faces;             ///< Сколько граней и сгенерированных даст кусок.
+  MeshCursor base;             ///< Смещения куска в глобальных массивах.
+};
+
 void ObjectLoader::loadObj(const std::string& filepath, Mesh& mesh,
-                           MaterialManager& materialManager) {
-  std::ifstream file(filepath);
-  if (!file.is_open()) {
+                           MaterialManager& materialManager, int threads,
+                           std::vector<std::string>* dependencies,
+                           LoadProgress* progress,
+                           const std::function<bool()>& beforeWrite) {
+  MappedFile file;
+  if (!file.open(filepath)) {
     std::cerr << "Could not open file " << filepath << "\n";
     throw std::runtime_error("File not found");
   }
 
-  std::string line;
-  std::string currentMaterialName;
-  uint32_t currentMaterialIndex = 0;  // 0 — дефолтный материал
+  if (threads <= 0) {
+    threads = file.size() >= kParallelMinBytes ? omp_get_max_threads() : 1;
+  }
 
-  while (std::getline(file, line)) {
-    std::istringstream iss(line);
-    std::string prefix;
-    iss >> prefix;
+  const char* begin = file.data();
+  const char* end = begin + file.size();
+  if (progress) {
+    // Параллельный разбор проходит текст трижды (атрибуты, подсчёт, грани).
+    progress->totalBytes.store(file.size() * (threads > 1 ? 3 : 1),
+                               std::memory_order_relaxed);
+    progress->fileBytes.store(file.size(), std::memory_order_relaxed);
+  }
+  if (threads > 1) {
+    parseObjParallel(begin, end, filepath, mesh, materialManager, threads,
+                     dependencies, progress, beforeWrite);
+  } else {
+    parseObj(begin, end, filepath, mesh, materialManager, dependencies,
+             progress, beforeWrite);
+  }
+  if (progress && progress->isCancelled()) mesh = Mesh{};
+}
 
-    if (prefix == "v") {
-      mesh.addVertex(parseVertex(iss));
-    } else if (prefix == "vn") {
-      mesh.addNormal(parseNormal(iss));
-    } else if (prefix == "vt") {
-      mesh.addUVCoordinate(parseUVcoordiantes(iss));
-    } else if (prefix == "mtllib") {
-      std::string mtlFileName;
-      iss >> mtlFileName;
+ObjectLoader::ObjCounts ObjectLoader::countElements(const char* begin,
+                                                    const char* end,
+                                                    bool exact) {
+  ObjCounts counts;
+  MeshCursor seen;  // сколько v/vt/vn прочитано к текущей строке
+  std::vector<FaceVertex> poly;
 
-      std::filesystem::path objPath(filepath);
-      std::filesystem::path dirPath = objPath.parent_path();
+  for (const char* line = begin; line < end;) {
+    const char* eol = lineEnd(line, end);
+    const char* p = line;
+    std::string_view keyword = readWord(p, eol);
 
-      std::string materialPath = resolveAssetPath(dirPath, mtlFileName);
+    if (keyword == "v") {
+      ++seen.vertices;
+    } else if (keyword == "vn") {
+      ++seen.normals;
+    } else if (keyword == "vt") {
+      ++seen.uvs;
+    } else if (keyword == "f" && exact) {
+      // Индексы разрешаем так же, как при разборе: битые и ссылки вперёд
+      // учтены, и массивы потом гарантированно не перевыделяются.
+      poly.clear();
+      for (std::string_view token = readWord(p, eol); !token.empty();
+           token = readWord(p, eol)) {
+        poly.push_back(parseFaceVertex(token, seen));
+      }
+      tallyPolygon(poly, counts);
+    } else if (keyword == "f") {
+      size_t corners = 0;
+      bool allNormals = true;
+      bool allUvs = true;
+      for (std::string_view token = readWord(p, eol); !token.empty();
+           token = readWord(p, eol)) {
+        ++corners;
+        size_t s1 = token.find('/');
+        size_t s2 = (s1 == std::string_view::npos) ? s1 : token.find('/', s1 + 1);
+        bool hasUv = s1 != std::string_view::npos &&
+                     (s2 == std::string_view::npos ? token.size() : s2) > s1 + 1;
+        bool hasNormal = s2 != std::string_view::npos && token.size() > s2 + 1;
+        allUvs = allUvs && hasUv;
+        allNormals = allNormals && hasNormal;
+      }
+      if (corners >= 3) {
+        counts.triangles += corners - 2;
+        if (!allNormals) counts.genNormals += corners - 2;
+        if (!allUvs) counts.genUvs += corners - 2;
+      }
+    }
 
-      MtlFileLoader::loadMtl(materialPath, materialManager);
+    line = (eol < end) ? eol + 1 : end;
+  }
+
+  counts.vertices = seen.vertices;
+  counts.normals = seen.normals;
+  counts.uvs = seen.uvs;
+  return counts;
+}
 
-    } else if (prefix == "usemtl") {
-      iss >> currentMaterialName;
+void ObjectLoader::parseObj(const char* begin, const char* end,
+                            const std::string& filepath, Mesh& mesh,
+                            MaterialManager& materialManager,
+                            std::vector<std::string>* dependencies,
+                            LoadProgress* progress,
+                            const std::function<bool()>& beforeWrite) {
+  // Размечаем массивы один раз. Файловые нормали/UV займут начало,
+  // сгенерированные пойдут следом; лишний хвост обрежем в конце.
+  const bool publishing = progress && progress->publishStep > 0;
+  const ObjCounts counts = countElements(begin, end, publishing);
+  if (beforeWrite && !beforeWrite()) return;
+  mesh.vertices_.resize(counts.vertices);
+  mesh.normals_.resize(counts.normals + counts.genNormals);
+  mesh.uvCoordinates_.resize(counts.uvs + counts.genUvs);
+  mesh.faces_.resize(counts.triangles);
+
+  MeshCursor cursor;
+  cursor.genNormals = static_cast<uint32_t>(counts.normals);
+  cursor.genUvs = static_cast<uint32_t>(counts.uvs);
+
+  uint32_t currentMaterialIndex = 0;  // 0 — дефолтный материал
+  std::vector<FaceVertex> poly;       // переиспользуется между строками
+  ProgressReporter reporter(progress, begin);
+  uint32_t nextPublish = publishing ? progress->publishStep : UINT32_MAX;
+
+  for (const char* line = begin; line < end;) {
+    if (!reporter.update(line, cursor.faces)) return;
+    const char* eol = lineEnd(line, end);
+    const char* p = line;
+    std::string_view keyword = readWord(p, eol);
+
+    if (keyword == "v") {
+      mesh.vertices_[cursor.vertices++] = parseVertex(p, eol);
+    } else if (keyword == "vn") {
+      mesh.normals_[cursor.normals++] = parseNormal(p, eol);
+    } else if (keyword == "vt") {
+      mesh.uvCoordinates_[cursor.uvs++] = parseUVcoordiantes(p, eol);
+    } else if (keyword == "f") {
+      poly.clear();
+      for (std::string_view token = readWord(p, eol); !token.empty();
+           token = readWord(p, eol)) {
+        poly.push_back(parseFaceVertex(token, cursor));
+      }
+      addPolygon(mesh, cursor, poly, currentMaterialIndex);
+      if (cursor.faces >= nextPublish) {
+        progress->publish(extentOf(cursor, static_cast<uint32_t>(counts.normals),
+                                   static_cast<uint32_t>(counts.uvs)));
+        nextPublish = cursor.faces + progress->publishStep;
+      }
+    } else if (keyword == "mtllib") {
+      loadMaterialLibrary(filepath, std::string(readWord(p, eol)),
+                          materialManager, dependencies);
+    } else if (keyword == "usemtl") {
+      std::string currentMaterialName(readWord(p, eol));
       currentMaterialIndex = materialManager.getMaterialId(currentMaterialName);
-    } else if (prefix == "f") {
-      std::vector<FaceVertex> poly;
-      std::string token;
-      while (iss >> token) poly.push_back(parseFaceVertex(token, mesh));
-      addPolygon(mesh, poly, currentMaterialIndex);
+    }
+
+    line = (eol < end) ? eol + 1 : end;
+  }
+
+  reporter.flush(end, cursor.faces);
+
+  // Предварительный проход дал верхнюю оценку — обрезаем до фактического.
+  mesh.normals_.resize(cursor.genNormals);
+  mesh.uvCoordinates_.resize(cursor.genUvs);
+  mesh.faces_.resize(cursor.faces);
+}
+
+void ObjectLoader::parseObjParallel(const char* begin, const char* end,
+                                    const std::string& filepath, Mesh& mesh,
+                                    MaterialManager& materialManager,
+                                    int threads,
+                                    std::vector<std::string>* dependencies,
+                                    LoadProgress* progress,
+                                    const std::function<bool()>& beforeWrite) {
+  // Режем по границам строк: каждый кусок заканчивается сразу после '\n'.
+  std::vector<ObjChunk> chunks(threads);
+  const size_t size = static_cast<size_t>(end - begin);
+  const char* cut = begin;
+  for (int i = 0; i < threads; ++i) {
+    chunks[i].begin = cut;
+    const char* target = std::max(cut, begin + size * (i + 1) / threads);
+    if (target > begin && target < end && target[-1] != '\n') {
+      const char* nl = lineEnd(target, end);
+      target = (nl < end) ? nl + 1 : end;
+    }
+    cut = (i + 1 == threads) ? end : target;
+    chunks[i].end = cut;
+  }
+
+  // 1. Каждый кусок читает свои v/vt/vn в локальные массивы.
+#pragma omp parallel for schedule(static, 1) num_threads(threads)
+  for (int i = 0; i < threads; ++i) parseChunkAttributes(chunks[i], progress);
+  if (stopped(progress)) return;
+  if (beforeWrite && !beforeWrite()) return;
+
+  // 2. Префиксные суммы атрибутов. mtllib/usemtl повторяем строго в порядке
+  //    файла — id материалов и их видимость совпадают с последовательным
+  //    разбором; грани в начале куска наследуют usemtl предыдущего.
+  MeshCursor total;
+  uint32_t currentMaterialIndex = 0;  // 0 — дефолтный материал
+  for (ObjChunk& chunk : chunks) {
+    chunk.base.vertices = total.vertices;
+    chunk.base.normals = total.normals;
+    chunk.base.uvs = total.uvs;
+    total.vertices += static_cast<uint32_t>(chunk.vertices.size());
+    total.normals += static_cast<uint32_t>(chunk.normals.size());
+    total.uvs += static_cast<uint32_t>(chunk.uvs.size());
+
+    chunk.startMaterial = currentMaterialIndex;
+    for (ObjChunk::Event& event : chunk.events) {
+      if (event.library) {
+        loadMaterialLibrary(filepath, event.name, materialManager,
+                            dependencies);
+      } else {
+        currentMaterialIndex = materialManager.getMaterialId(event.name);
+      }
+      event.material = currentMaterialIndex;
+    }
+  }
+
+  // 3. Индексы граней зависят только от счётчиков — считаем, сколько граней
+  //    и сгенерированных нормалей/UV даст каждый кусок.
+#pragma omp parallel for schedule(static, 1) num_threads(threads)
+  for (int i = 0; i < threads; ++i) {
+    ObjChunk& chunk = chunks[i];
+    forEachPolygon(
+        chunk,
+        [&chunk](const std::vector<FaceVertex>& poly, uint32_t) {
+          tallyPolygon(poly, chunk.faces);
+        },
+        progress);
+  }
+  if (stopped(progress)) return;
+
+  // 4. Префиксные суммы граней: сгенерированные нормали/UV идут сразу за
+  //    файловыми в порядке граней, как при последовательном разборе.
+  total.genNormals = total.normals;
+  total.genUvs = total.uvs;
+  for (ObjChunk& chunk : chunks) {
+    chunk.base.faces = total.faces;
+    chunk.base.genNormals = total.genNormals;
+    chunk.base.genUvs = total.genUvs;
+    total.faces += static_cast<uint32_t>(chunk.faces.triangles);
+    total.genNormals += static_cast<uint32_t>(chunk.faces.genNormals);
+    total.genUvs += static_cast<uint32_t>(chunk.faces.genUvs);
+  }
+
+  mesh.vertices_.resize(total.vertices);
+  mesh.normals_.resize(total.genNormals);
+  mesh.uvCoordinates_.resize(total.genUvs);
+  mesh.faces_.resize(total.faces);
+
+  // Опубликованный префикс граней непрерывен: кусок k входит в него, когда
+  // куски 0..k-1 дописаны. Публикация редкая — раз в publishStep граней
+  // куска, — поэтому записанное кусками сводится под мьютексом.
+  const bool publishing = progress && progress->publishStep > 0;
+  std::vector<MeshCursor> written(threads);
+  std::vector<uint8_t> finished(threads, 0);
+  for (int i = 0; i < threads; ++i) written[i] = chunks[i].base;
+  std::mutex writtenMutex;
+  uint32_t publishedFaces = 0;
+  auto publishPrefix = [&](int i, const MeshCursor& writer, bool done) {
+    std::lock_guard<std::mutex> lock(writtenMutex);
+    written[i] = writer;
+    finished[i] = done;
+    int k = 0;
+    while (k + 1 < threads && finished[k]) ++k;
+    MeshCursor prefix = written[k];
+    if (prefix.faces <= publishedFaces) return;
+    publishedFaces = prefix.faces;
+    // Атрибуты к этому моменту уже все на местах.
+    prefix.vertices = total.vertices;
+    prefix.normals = total.normals;
+    prefix.uvs = total.uvs;
+    progress->publish(extentOf(prefix, total.normals, total.uvs));
+  };
+
+  // 5. Атрибуты — на свои места; после барьера все вершины на месте, и куски
+  //    строят грани (и нормали граней) прямо в меше, не пересекаясь.
+#pragma omp parallel num_threads(threads)
+  {
+#pragma omp for schedule(static, 1)
+    for (int i = 0; i < threads; ++i) {
+      const ObjChunk& chunk = chunks[i];
+      std::copy(chunk.vertices.begin(), chunk.vertices.end(),
+                mesh.vertices_.begin() + chunk.base.vertices);
+      std::copy(chunk.normals.begin(), chunk.normals.end(),
+                mesh.normals_.begin() + chunk.base.normals);
+      std::copy(chunk.uvs.begin(), chunk.uvs.end(),
+                mesh.uvCoordinates_.begin() + chunk.base.uvs);
+    }
+
+#pragma omp for schedule(static, 1)
+    for (int i = 0; i < threads; ++i) {
+      MeshCursor writer = chunks[i].base;
+      uint32_t nextPublish =
+          publishing ? writer.faces + progress->publishStep : UINT32_MAX;
+      forEachPolygon(
+          chunks[i],
+          [&](const std::vector<FaceVertex>& poly, uint32_t materialIndex) {
+            addPolygon(mesh, writer, poly, materialIndex);
+            if (writer.faces >= nextPublish) {
+              publishPrefix(i, writer, false);
+              nextPublish = writer.faces + progress->publishStep;
+            }
+          },
+          progress, &writer.faces);
+      if (publishing && !stopped(progress)) publishPrefix(i, writer, true);
     }
   }
+}
 
-  file.close();
+void ObjectLoader::parseChunkAttributes(ObjChunk& chunk,
+                                        LoadProgress* progress) {
+  ProgressReporter reporter(progress, chunk.begin);
+  for (const char* line = chunk.begin; line < chunk.end;) {
+    if (!reporter.update(line, 0)) return;
+    const char* eol = lineEnd(line, chunk.end);
+    const char* p = line;
+    std::string_view keyword = readWord(p, eol);
+
+    if (keyword == "v") {
+      chunk.vertices.push_back(parseVertex(p, eol));
+    } else if (keyword == "vn") {
+      chunk.normals.push_back(parseNormal(p, eol));
+    } else if (keyword == "vt") {
+      chunk.uvs.push_back(parseUVcoordiantes(p, eol));
+    } else if (keyword == "mtllib" || keyword == "usemtl") {
+      chunk.events.push_back(
+          {keyword == "mtllib", std::string(readWord(p, eol)), 0});
+    }
+
+    line = (eol < chunk.end) ? eol + 1 : chunk.end;
+  }
+  reporter.flush(chunk.end, 0);
 }
 
-Vertex ObjectLoader::parseVertex(std::istringstream& iss) {
+template <typename Fn>
+void ObjectLoader::forEachPolygon(const ObjChunk& chunk, Fn&& fn,
+                                  LoadProgress* progress,
+                                  const uint32_t* faces) {
+  MeshCursor counts = chunk.base;  // глобальные счётчики по ходу куска
+  uint32_t materialIndex = chunk.startMaterial;
+  size_t event = 0;
+  std::vector<FaceVertex> poly;
+  auto built = [faces] { return faces ? *faces : 0u; };
+  ProgressReporter reporter(progress, chunk.begin, built());
+
+  for (const char* line = chunk.begin; line < chunk.end;) {
+    if (!reporter.update(line, built())) return;
+    const char* eol = lineEnd(line, chunk.end);
+    const char* p = line;
+    std::string_view keyword = readWord(p, eol);
+
+    if (keyword == "v") {
+      ++counts.vertices;
+    } else if (keyword == "vn") {
+      ++counts.normals;
+    } else if (keyword == "vt") {
+      ++counts.uvs;
+    } else if (keyword == "f") {
+      poly.clear();
+      for (std::string_view token = readWord(p, eol); !token.empty();
+           token = readWord(p, eol)) {
+        poly.push_back(parseFaceVertex(token, counts));
+      }
+      fn(poly, materialIndex);
+    } else if (keyword == "mtllib" || keyword == "usemtl") {
+      materialIndex = chunk.events[event++].material;
+    }
+
+    line = (eol < chunk.end) ? eol + 1 : chunk.end;
+  }
+  reporter.flush(chunk.end, built());
+}
+
+void ObjectLoader::loadMaterialLibrary(const std::string& filepath,
+                                       const std::string& mtlFileName,
+                                       MaterialManager& materialManager,
+                                       std::vector<std::string>* dependencies) {
+  std::filesystem::path objPath(filepath);
+  std::filesystem::path dirPath = objPath.parent_path();
+
+  std::string materialPath = resolveAssetPath(dirPath, mtlFileName);
+
+  MtlFileLoader::loadMtl(materialPath, materialManager, dependencies);
+}
+
+Vertex ObjectLoader::parseVertex(const char*& p, const char* end) {
   Vertex vertex;
-  if (iss >> vertex[0] >> vertex[1] >> vertex[2]) {
-    vertex[3] = 1.0f;
-  } else {
+  if (!parseFloats(p, end, vertex.data(), 3)) {
     std::cerr << "Invalid vertex data\n";
   }
+  vertex[3] = 1.0f;
   return vertex;
 }
 
-Normal ObjectLoader::parseNormal(std::istringstream& iss) {
+Normal ObjectLoader::parseNormal(const char*& p, const char* end) {
   Normal normal;
-  if (iss >> normal[0] >> normal[1] >> normal[2]) {
-  } else {
+  if (!parseFloats(p, end, normal.data(), 3)) {
     std::cerr << "Invalid normal data\n";
   }
   return normal;
 }
 
-UVCoordinate ObjectLoader::parseUVcoordiantes(std::istringstream& iss) {
+UVCoordinate ObjectLoader::parseUVcoordiantes(const char*& p,
+                                              const char* end) {
   UVCoordinate uv;
-  if (iss >> uv[0] >> uv[1]) {
-  } else {
+  if (!parseFloats(p, end, uv.data(), 2)) {
     std::cerr << "Invalid uv coordinate\n";
   }
   return uv;
 }
 
-ObjectLoader::FaceVertex ObjectLoader::parseFaceVertex(const std::string& token,
-                                                       const Mesh& mesh) {
+bool ObjectLoader::parseFloats(const char*& p, const char* end, float* out,
+                               int count) {
+  for (int i = 0; i < count; ++i) {
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+') ++p;  // from_chars не принимает ведущий '+'
+    auto [next, ec] = std::from_chars(p, end, out[i]);
+    if (ec != std::errc()) {
+      std::fill(out + i, out + count, 0.0f);
+      return false;
+    }
+    p = next;
+  }
+  return true;
+}
+
+ObjectLoader::FaceVertex ObjectLoader::parseFaceVertex(
+    std::string_view token, const MeshCursor& cursor) {
   // Токен может быть: "v", "v/vt", "v//vn", "v/vt/vn".
   int raw[3] = {0, 0, 0};
   bool present[3] = {false, false, false};
 
-  size_t start = 0;
-  for (int part = 0; part < 3; ++part) {
-    size_t slash = token.find('/', start);
-    size_t len =
-        (slash == std::string::npos) ? std::string::npos : slash - start;
-    std::string piece = token.substr(start, len);
-    if (!piece.empty()) {
-      try {
-        raw[part] = std::stoi(piece);
-        present[part] = true;
-      } catch (const std::exception&) {
-        present[part] = false;
-      }
+  const char* p = token.data();
+  const char* end = p + token.size();
+  for (int part = 0; part < 3 && p <= end; ++part) {
+    const char* slash = static_cast<const char*>(
+        std::memchr(p, '/', static_cast<size_t>(end - p)));
+    const char* pieceEnd = slash ? slash : end;
+    if (pieceEnd > p) {
+      const char* digits = (*p == '+') ? p + 1 : p;
+      present[part] =
+          std::from_chars(digits, pieceEnd, raw[part]).ec == std::errc();
     }
-    if (slash == std::string::npos) break;
-    start = slash + 1;
+    if (!slash) break;
+    p = slash + 1;
   }
 
-  // OBJ допускает отрицательные (относительные) индексы: -1 — последний элемент.
-  auto resolve = [](int idx, size_t count) -> int {
-    if (idx > 0) return idx - 1;                          // 1-based -> 0-based
-    if (idx < 0) return static_cast<int>(count) + idx;    // относительный
-    return -1;
+  // OBJ допускает отрицательные (относительные) индексы: -1 — последний
+  // прочитанный из файла элемент; сгенерированные нормали и UV не в счёт.
+  // Ссылки вперёд и за границы считаем отсутствующими.
+  auto resolve = [](int idx, uint32_t count) -> int {
+    long long i = idx > 0 ? idx - 1LL : static_cast<long long>(count) + idx;
+    return (idx != 0 && i >= 0 && i < count) ? static_cast<int>(i) : -1;
   };
 
   FaceVertex fv{-1, -1, -1};
-  if (present[0]) fv.v = resolve(raw[0], mesh.vertices_.size());
-  if (present[1]) fv.vt = resolve(raw[1], mesh.uvCoordinates_.size());
-  if (present[2]) fv.vn = resolve(raw[2], mesh.normals_.size());
+  if (present[0]) fv.v = resolve(raw[0], cursor.vertices);
+  if (present[1]) fv.vt = resolve(raw[1], cursor.uvs);
+  if (present[2]) fv.vn = resolve(raw[2], cursor.normals);
   return fv;
 }
 
-void ObjectLoader::addPolygon(Mesh& mesh, const std::vector<FaceVertex>& poly,
+void ObjectLoader::addPolygon(Mesh& mesh, MeshCursor& cursor,
+                              const std::vector<FaceVertex>& poly,
                               uint32_t materialIndex) {
   if (poly.size() < 3) {
     std::cerr << "Invalid face data (вершин < 3)\n";
@@ -153,8 +597,10 @@ void ObjectLoader::addPolygon(Mesh& mesh, const std::vector<FaceVertex>& poly,
       Normal n = (p1 - p0).cross(p2 - p0);
       float len = n.norm();
       n = (len > 1e-8f) ? Normal(n / len) : Normal(0.0f, 0.0f, 1.0f);
-      mesh.addNormal(n);
-      genNormalIdx = static_cast<uint32_t>(mesh.normals_.size() - 1);
+      genNormalIdx = cursor.genNormals++;
+      // Оценка предварительного прохода не учла нечисловые индексы.
+      if (genNormalIdx >= mesh.normals_.size()) mesh.normals_.emplace_back();
+      mesh.normals_[genNormalIdx] = n;
     }
 
     // UV-фолбэк: один общий (0,0) на треугольник, если у угла нет vt.
@@ -170,15 +616,46 @@ void ObjectLoader::addPolygon(Mesh& mesh, const std::vector<FaceVertex>& poly,
         face.uvCoordinateIndex[k] = static_cast<uint32_t>(tri[k].vt);
       } else {
         if (!defaultUvCreated) {
-          mesh.addUVCoordinate(UVCoordinate(0.0f, 0.0f));
-          defaultUvIdx = static_cast<uint32_t>(mesh.uvCoordinates_.size() - 1);
+          defaultUvIdx = cursor.genUvs++;
+          if (defaultUvIdx >= mesh.uvCoordinates_.size()) {
+            mesh.uvCoordinates_.emplace_back();
+          }
+          mesh.uvCoordinates_[defaultUvIdx] = UVCoordinate(0.0f, 0.0f);
           defaultUvCreated = true;
         }
         face.uvCoordinateIndex[k] = defaultUvIdx;
       }
     }
 
-    mesh.addFace(face);
+    if (cursor.faces >= mesh.faces_.size()) mesh.faces_.emplace_back();
+    mesh.faces_[cursor.faces++] = face;
+  }
+}
+MeshExtent ObjectLoader::extentOf(const MeshCursor& cursor,
+                                  uint32_t genNormalsBegin,
+                                  uint32_t genUvsBegin) {
+  MeshExtent extent;
+  extent.vertices = cursor.vertices;
+  extent.normals = cursor.normals;
+  extent.genNormalsBegin = genNormalsBegin;
+  extent.genNormals = cursor.genNormals;
+  extent.uvs = cursor.uvs;
+  extent.genUvsBegin = genUvsBegin;
+  extent.genUvs = cursor.genUvs;
+  extent.faces = cursor.faces;
+  return extent;
+}
+
+void ObjectLoader::tallyPolygon(const std::vector<FaceVertex>& poly,
+                                ObjCounts& counts) {
+  // Зеркало addPolygon: те же пропуски и те же условия генерации.
+  for (size_t i = 1; i + 1 < poly.size(); ++i) {
+    const FaceVertex tri[3] = {poly[0], poly[i], poly[i + 1]};
+    if (tri[0].v < 0 || tri[1].v < 0 || tri[2].v < 0) continue;
+
+    ++counts.triangles;
+    if (tri[0].vn < 0 || tri[1].vn < 0 || tri[2].vn < 0) ++counts.genNormals;
+    if (tri[0].vt < 0 || tri[1].vt < 0 || tri[2].vt < 0) ++counts.genUvs;
   }
 }
-}  // namespace s21
\ No newline at end of file
+}  // namespace s21
@@ -1,6 +1,12 @@
 #ifndef OBJECT_LOADER_H
 #define OBJECT_LOADER_H
 
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "backend/loaders/loadProgress.h"
 #include "backend/material_manager/material_manager.h"
 #include "backend/mesh/mesh.h"
 #include "backend/types.h"
@@ -9,6 +15,11 @@ namespace s21 {
 /**
  * @class ObjectLoader
  * @brief Класс для загрузки 3D-объектов из файлов .obj.
+ *
+ * Файл отображается в память и разбирается на месте: строки не копируются,
+ * числа читаются через std::from_chars. Предварительный проход считает
+ * элементы, поэтому массивы меша выделяются один раз и заполняются по
+ * индексу.
  */
 class ObjectLoader {
  public:
@@ -18,9 +29,25 @@ class ObjectLoader {
    * @param mesh Объект Mesh, в который загружается геометрия.
    * @param materialManager Менеджер материалов, используемый для загрузки
    * материалов.
+   * @param threads Число потоков разбора: 0 — авто (большие файлы режутся на
+   * куски по числу потоков OpenMP), 1 — последовательно. Результат от числа
+   * потоков не зависит побайтно.
+   * @param dependencies Если задан, сюда дописываются пути всех файлов, от
+   * которых зависит результат (.mtl и текстуры), — для проверки кеша.
+   * @param progress Если задан, сюда пишется прогресс; при отмене разбор
+   * прерывается и mesh остаётся пустым (материалы могут успеть добавиться).
+   * С progress->publishStep готовые грани публикуются по ходу разбора.
+   * Если выставлен progress->superseded, разбор бросается до первой записи.
+   * @param beforeWrite Если задан, зовётся один раз перед первой записью в
+   * mesh и materialManager; false — разбор не нужен, загрузчик выходит, ничего
+   * не изменив. До этого момента mesh и materialManager можно заполнять из
+   * другого потока (например, из кеша).
    */
   static void loadObj(const std::string& filepath, Mesh& mesh,
-                      MaterialManager& materialManager);
+                      MaterialManager& materialManager, int threads = 0,
+                      std::vector<std::string>* dependencies = nullptr,
+                      LoadProgress* progress = nullptr,
+                      const std::function<bool()>& beforeWrite = {});
 
  private:
   /**
@@ -29,55 +56,219 @@ class ObjectLoader {
   ObjectLoader(){};
 
   /**
-   * @brief Разбирает вершину из потока.
-   * @param iss Поток входных данных.
-   * @return Разобранная вершина.
+   * @struct FaceVertex
+   * @brief Один угол грани: 0-based индексы вершины/UV/нормали.
+   *        Значение -1 означает, что компонента отсутствует в файле.
+   */
+  struct FaceVertex {
+    int v;
+    int vt;
+    int vn;
+  };
+
+  /**
+   * @struct ObjCounts
+   * @brief Результат предварительного прохода. Сгенерированные нормали и UV —
+   *        верхняя оценка (треугольники с битыми индексами потом
+   * отбрасываются).
+   */
+  struct ObjCounts {
+    size_t vertices = 0;    ///< Строк "v".
+    size_t normals = 0;     ///< Строк "vn".
+    size_t uvs = 0;         ///< Строк "vt".
+    size_t triangles = 0;   ///< Треугольников после веерной триангуляции.
+    size_t genNormals = 0;  ///< Треугольников без vn хотя бы у одного угла.
+    size_t genUvs = 0;      ///< Треугольников без vt хотя бы у одного угла.
+  };
+
+  /**
+   * @struct MeshCursor
+   * @brief Сколько элементов каждого массива уже заполнено при разборе.
+   *        Файловые нормали/UV лежат в начале массивов, сгенерированные —
+   *        следом за ними.
+   */
+  struct MeshCursor {
+    uint32_t vertices = 0;  ///< Прочитано вершин.
+    uint32_t normals = 0;   ///< Прочитано нормалей из файла.
+    uint32_t uvs = 0;       ///< Прочитано UV из файла.
+    uint32_t genNormals = 0;  ///< Следующий слот сгенерированной нормали.
+    uint32_t genUvs = 0;      ///< Следующий слот сгенерированной UV.
+    uint32_t faces = 0;       ///< Записано граней.
+  };
+
+  /**
+   * @struct ObjChunk
+   * @brief Кусок файла по границам строк для параллельного разбора
+   *        (определён в ObjectLoader.cpp).
+   */
+  struct ObjChunk;
+
+  /**
+   * @brief Считает элементы файла без разбора чисел.
+   * @param begin Начало текста.
+   * @param end Конец текста.
+   * @param exact Разбирать индексы граней: медленнее, но счёт точный (нужен,
+   * когда меш публикуется по ходу загрузки и не должен перевыделяться).
+   * @return Количество вершин, нормалей, UV и треугольников.
+   */
+  static ObjCounts countElements(const char* begin, const char* end,
+                                 bool exact);
+
+  /**
+   * @brief Разбирает текст .obj, уже отображённый в память.
+   * @param begin Начало текста.
+   * @param end Конец текста.
+   * @param filepath Путь к файлу .obj (для поиска mtllib).
+   * @param mesh Меш, в который загружается геометрия.
+   * @param materialManager Менеджер материалов.
+   * @param dependencies Куда дописывать пути .mtl и текстур (может быть null).
+   * @param progress Прогресс и флаг отмены (может быть null).
+   * @param beforeWrite См. loadObj (может быть пустым).
+   */
+  static void parseObj(const char* begin, const char* end,
+                       const std::string& filepath, Mesh& mesh,
+                       MaterialManager& materialManager,
+                       std::vector<std::string>* dependencies,
+                       LoadProgress* progress,
+                       const std::function<bool()>& beforeWrite);
+
+  /**
+   * @brief Разбирает текст .obj параллельно: куски по строкам читают v/vt/vn
+   *        в локальные массивы, затем префиксные суммы дают глобальные
+   *        смещения, и грани пишутся сразу на свои места в меше.
+   *
+   * Публикуется непрерывный префикс граней: кусок k попадает в него, когда
+   * куски 0..k-1 дописаны.
+   * @param begin Начало текста.
+   * @param end Конец текста.
+   * @param filepath Путь к файлу .obj (для поиска mtllib).
+   * @param mesh Меш, в который загружается геометрия.
+   * @param materialManager Менеджер материалов.
+   * @param threads Число кусков (потоков).
+   * @param dependencies Куда дописывать пути .mtl и текстур (может быть null).
+   * @param progress Прогресс и флаг отмены (может быть null).
+   * @param beforeWrite См. loadObj (может быть пустым): зовётся после
+   * чтения атрибутов, до материалов и граней.
+   */
+  static void parseObjParallel(const char* begin, const char* end,
+                               const std::string& filepath, Mesh& mesh,
+                               MaterialManager& materialManager, int threads,
+                               std::vector<std::string>* dependencies,
+                               LoadProgress* progress,
+                               const std::function<bool()>& beforeWrite);
+
+  /**
+   * @brief Читает v/vt/vn куска в его локальные массивы и запоминает
+   *        mtllib/usemtl по порядку.
+   * @param chunk Кусок файла.
+   * @param progress Прогресс и флаг отмены (может быть null).
+   */
+  static void parseChunkAttributes(ObjChunk& chunk, LoadProgress* progress);
+
+  /**
+   * @brief Проходит грани куска, разрешая индексы относительно глобальных
+   *        счётчиков на начало куска.
+   * @param chunk Кусок с уже известными смещениями и материалами.
+   * @param fn Вызывается для каждого полигона: fn(poly, materialIndex).
+   * @param progress Прогресс и флаг отмены (может быть null).
+   * @param faces Счётчик граней, которые строит fn, — о них отчитываемся
+   *        по ходу куска (null — fn граней не строит).
+   */
+  template <typename Fn>
+  static void forEachPolygon(const ObjChunk& chunk, Fn&& fn,
+                             LoadProgress* progress,
+                             const uint32_t* faces = nullptr);
+
+  /**
+   * @brief Подгружает библиотеку материалов, указанную в mtllib.
+   * @param filepath Путь к файлу .obj.
+   * @param mtlFileName Имя из строки mtllib.
+   * @param materialManager Менеджер материалов.
+   * @param dependencies Куда дописывать пути .mtl и текстур (может быть null).
+   */
+  static void loadMaterialLibrary(const std::string& filepath,
+                                  const std::string& mtlFileName,
+                                  MaterialManager& materialManager,
+                                  std::vector<std::string>* dependencies);
+
+  /**
+   * @brief Разбирает вершину из строки.
+   * @param p Текущая позиция (сдвигается за прочитанное).
+   * @param end Конец строки.
+   * @return Разобранная вершина (w = 1).
    */
-  static Vertex parseVertex(std::istringstream& iss);
+  static Vertex parseVertex(const char*& p, const char* end);
 
   /**
-   * @brief Разбирает нормаль из потока.
-   * @param iss Поток входных данных.
+   * @brief Разбирает нормаль из строки.
+   * @param p Текущая позиция (сдвигается за прочитанное).
+   * @param end Конец строки.
    * @return Разобранная нормаль.
    */
-  static Normal parseNormal(std::istringstream& iss);
+  static Normal parseNormal(const char*& p, const char* end);
 
   /**
-   * @brief Разбирает координаты текстурирования из потока.
-   * @param iss Поток входных данных.
+   * @brief Разбирает координаты текстурирования из строки.
+   * @param p Текущая позиция (сдвигается за прочитанное).
+   * @param end Конец строки.
    * @return Разобранные координаты UV.
    */
-  static UVCoordinate parseUVcoordiantes(std::istringstream& iss);
+  static UVCoordinate parseUVcoordiantes(const char*& p, const char* end);
 
   /**
-   * @struct FaceVertex
-   * @brief Один угол грани: 0-based индексы вершины/UV/нормали.
-   *        Значение -1 означает, что компонента отсутствует в файле.
+   * @brief Читает до count чисел с плавающей точкой из строки.
+   * @param p Текущая позиция (сдвигается за прочитанное).
+   * @param end Конец строки.
+   * @param out Массив для результата.
+   * @param count Сколько чисел нужно.
+   * @return true, если прочитаны все count чисел.
    */
-  struct FaceVertex {
-    int v;
-    int vt;
-    int vn;
-  };
+  static bool parseFloats(const char*& p, const char* end, float* out,
+                          int count);
 
   /**
    * @brief Разбирает один токен грани (v, v/vt, v//vn, v/vt/vn).
-   *        Поддерживает относительные (отрицательные) индексы OBJ.
+   *        Поддерживает относительные (отрицательные) индексы OBJ. Индексы
+   *        считаются только по элементам из файла: сгенерированные нормали и
+   *        UV в нумерацию не входят. Индекс, указывающий на ещё не
+   *        прочитанный элемент, считается отсутствующим.
    * @param token Токен угла грани.
-   * @param mesh Меш (нужен для разрешения относительных индексов).
+   * @param cursor Сколько вершин/UV/нормалей прочитано к этой строке.
    * @return Разобранный угол с 0-based индексами.
    */
-  static FaceVertex parseFaceVertex(const std::string& token, const Mesh& mesh);
+  static FaceVertex parseFaceVertex(std::string_view token,
+                                    const MeshCursor& cursor);
 
   /**
    * @brief Триангулирует полигон веером и добавляет грани в меш,
    *        генерируя нормали и UV там, где их нет в файле.
-   * @param mesh Меш, в который добавляются грани.
+   * @param mesh Меш, в который добавляются грани (массивы уже размечены).
+   * @param cursor Позиции записи в массивы меша.
    * @param poly Углы полигона (>= 3).
    * @param materialIndex Индекс материала.
    */
-  static void addPolygon(Mesh& mesh, const std::vector<FaceVertex>& poly,
+  static void addPolygon(Mesh& mesh, MeshCursor& cursor,
+                         const std::vector<FaceVertex>& poly,
                          uint32_t materialIndex);
+
+  /**
+   * @brief Записанная часть меша для публикации по ходу загрузки.
+   * @param cursor Позиции записи.
+   * @param genNormalsBegin Начало участка сгенерированных нормалей.
+   * @param genUvsBegin Начало участка сгенерированных UV.
+   * @return Диапазоны, которые уже можно читать.
+   */
+  static MeshExtent extentOf(const MeshCursor& cursor, uint32_t genNormalsBegin,
+                             uint32_t genUvsBegin);
+
+  /**
+   * @brief Считает, сколько граней и сгенерированных нормалей/UV даст
+   *        addPolygon для этого полигона, ничего не записывая.
+   * @param poly Углы полигона.
+   * @param counts Счётчики triangles/genNormals/genUvs для увеличения.
+   */
+  static void tallyPolygon(const std::vector<FaceVertex>& poly,
+                           ObjCounts& counts);
 };
 }  // namespace s21
 #endif  // OBJECT_LOADER_H
@@ -1,5 +1,9 @@
 #include "TextureLoader.h"
 
+#include <omp.h>
+
+#include <algorithm>
+
 #include "backend/material_manager/material_manager.h"
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -10,16 +14,53 @@
 namespace s21 {
 Texture TextureLoader::loadTexture(const std::string &filePath) {
   Texture texture;
-  texture.colors_ =
-      loadImageToEigenArray(filePath, texture.width_, texture.height_);
+  std::vector<Texel> texels =
+      loadImageRgba8(filePath, texture.width_, texture.height_);
+  buildMipChain(texels, texture.width_, texture.height_);
+  texture.colors_ = std::move(texels);
   return texture;
 }
 
-std::vector<Color> TextureLoader::loadImageToEigenArray(
-    const std::string &filename, int &width, int &height) {
-  int channels = 3;
+void TextureLoader::buildMipChain(std::vector<Texel> &texels, int width,
+                                  int height) {
+  if (texels.empty()) return;
+  texels.resize(Texture::mipTexels(width, height));
+  // Мелкие уровни быстрее посчитать в одном потоке.
+  constexpr int kParallelMinTexels = 64 * 64;
+
+  Texel *src = texels.data();
+  while (width > 1 || height > 1) {
+    const int w = std::max(1, width / 2);
+    const int h = std::max(1, height / 2);
+    Texel *dst = src + size_t(width) * size_t(height);
+#pragma omp parallel for schedule(static) if (w * h >= kParallelMinTexels)
+    for (int y = 0; y < h; ++y) {
+      const Texel *row0 = src + size_t(2 * y) * width;
+      const Texel *row1 = src + size_t(std::min(2 * y + 1, height - 1)) * width;
+      for (int x = 0; x < w; ++x) {
+        const int x0 = 2 * x;
+        const int x1 = std::min(x0 + 1, width - 1);
+        const Texel block[4] = {row0[x0], row0[x1], row1[x0], row1[x1]};
+        Texel average = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+          uint32_t sum = 2;  // округление
+          for (Texel texel : block) sum += (texel >> shift) & 0xFFu;
+          average |= (sum / 4) << shift;
+        }
+        dst[size_t(y) * w + x] = average;
+      }
+    }
+    src = dst;
+    width = w;
+    height = h;
+  }
+}
+
+std::vector<Texel> TextureLoader::loadImageRgba8(const std::string &filename,
+                                                 int &width, int &height) {
+  int channels = 4;
   unsigned char *imageData =
-      stbi_load(filename.c_str(), &width, &height, &channels, 3);
+      stbi_load(filename.c_str(), &width, &height, &channels, 4);
 
   if (!imageData) {
     // Раньше тут был exit(1). Возвращаем пустую текстуру: меш отрисуется
@@ -31,22 +72,17 @@ std::vector<Color> TextureLoader::loadImageToEigenArray(
     return {};
   }
 
-  std::vector<Eigen::Vector3f> pixelColors;
-  pixelColors.reserve(width * height);
-
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      int index = (y * width + x) * 3;
-      float r = imageData[index];
-      float g = imageData[index + 1];
-      float b = imageData[index + 2];
-
-      pixelColors.emplace_back(r, g, b);
-    }
+  // stb отдаёт байты R, G, B, A подряд; сборка сдвигами не зависит от
+  // порядка байт процессора.
+  std::vector<Texel> texels(size_t(width) * size_t(height));
+  for (size_t i = 0; i < texels.size(); ++i) {
+    const unsigned char *p = imageData + 4 * i;
+    texels[i] = Texel(p[0]) | Texel(p[1]) << 8 | Texel(p[2]) << 16 |
+                Texel(p[3]) << 24;
   }
 
   stbi_image_free(imageData);
 
-  return pixelColors;
+  return texels;
 }
 }  // namespace s21
\ No newline at end of file
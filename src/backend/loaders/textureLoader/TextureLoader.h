@@ -32,14 +32,30 @@ class TextureLoader {
   TextureLoader(){};
 
   /**
-   * @brief Загружает изображение в массив Eigen.
+   * @brief Декодирует изображение сразу в упакованные тексели RGBA8.
+   *
+   * Без альфа-канала в файле A = 255.
    * @param filename Путь к файлу изображения.
    * @param width Ширина изображения (возвращаемое значение).
    * @param height Высота изображения (возвращаемое значение).
-   * @return Вектор цветов, представляющий изображение.
+   * @return Тексели изображения построчно.
    */
-  static std::vector<Color> loadImageToEigenArray(const std::string &filename,
-                                                  int &width, int &height);
+  static std::vector<Texel> loadImageRgba8(const std::string &filename,
+                                           int &width, int &height);
+
+  /**
+   * @brief Дописывает к уровню 0 остальные уровни mip-цепочки.
+   *
+   * Тексель уровня — среднее блока 2x2 предыдущего по каждому каналу с
+   * округлением; на оси, уже равной 1, блок вырождается. Строки уровня
+   * считаются параллельно.
+   * @param texels Уровень 0 размером width x height; после вызова — вся
+   * цепочка в раскладке Texture::colors_.
+   * @param width Ширина уровня 0.
+   * @param height Высота уровня 0.
+   */
+  static void buildMipChain(std::vector<Texel> &texels, int width,
+                            int height);
 };
 }  // namespace s21
 #endif
@@ -1,6 +1,41 @@
 #include "material_manager.h"
 
+#include <algorithm>
+
 namespace s21 {
+size_t Texture::mipTexels(int width, int height) {
+  if (width <= 0 || height <= 0) return 0;
+  size_t count = 0;
+  while (true) {
+    count += size_t(width) * size_t(height);
+    if (width == 1 && height == 1) return count;
+    width = std::max(1, width / 2);
+    height = std::max(1, height / 2);
+  }
+}
+
+int Texture::levels() const {
+  if (colors_.empty()) return 0;
+  int count = 1;
+  for (int w = width_, h = height_; w > 1 || h > 1; ++count) {
+    w = std::max(1, w / 2);
+    h = std::max(1, h / 2);
+  }
+  return count;
+}
+
+const Texel *Texture::level(int level, int &width, int &height) const {
+  const Texel *texels = colors_.data();
+  width = width_;
+  height = height_;
+  for (int l = 0; l < level; ++l) {
+    texels += size_t(width) * size_t(height);
+    width = std::max(1, width / 2);
+    height = std::max(1, height / 2);
+  }
+  return texels;
+}
+
 MaterialManager::MaterialManager() {
   // Индекс 0 — дефолтный материал (нейтральный серый, без текстуры).
   Material def;
@@ -32,4 +67,32 @@ uint32_t MaterialManager::getMaterialId(std::string &name) const {
   auto it = mapMaterial_.find(name);
   return (it != mapMaterial_.end()) ? it->second : 0;  // 0 — дефолтный материал
 }
+
+uint32_t MaterialManager::size() const {
+  return static_cast<uint32_t>(materials_.size());
+}
+
+std::string MaterialManager::getMaterialName(uint32_t idMaterial) const {
+  for (const auto &[name, id] : mapMaterial_) {
+    if (id == idMaterial) return name;
+  }
+  return {};
+}
+
+void MaterialManager::reserveIds(uint32_t firstFree) {
+  while (materials_.size() < firstFree) materials_.push_back(materials_[0]);
+}
+
+uint32_t MaterialManager::merge(MaterialManager &&other, uint32_t from) {
+  const uint32_t first = size();
+  for (auto &[name, id] : other.mapMaterial_) {
+    if (id >= from) mapMaterial_.insert_or_assign(name, id - from + first);
+  }
+  for (size_t id = from; id < other.materials_.size(); ++id) {
+    materials_.push_back(std::move(other.materials_[id]));
+  }
+  other.materials_.clear();
+  other.mapMaterial_.clear();
+  return first;
+}
 }  // namespace s21
\ No newline at end of file
@@ -5,17 +5,40 @@
 #include <unordered_map>
 #include <vector>
 
+#include "backend/mesh/mappedVector.h"
 #include "backend/types.h"
 
 namespace s21 {
 /**
  * @struct Texture
  * @brief Структура, представляющая текстуру.
+ *
+ * colors_ хранит mip-цепочку подряд: уровень 0 размером width_ x height_,
+ * затем каждый следующий вдвое меньше по обеим осям (но не меньше 1) —
+ * до уровня 1 x 1. Тексели упакованы в RGBA8 — вчетверо меньше памяти и
+ * трафика, чем три float на тексель.
  */
 struct Texture {
-  std::vector<Color> colors_;  ///< Массив цветов текстуры.
-  int width_;                  ///< Ширина текстуры.
-  int height_;                 ///< Высота текстуры.
+  MappedVector<Texel> colors_;  ///< Уровни mip-цепочки подряд.
+  int width_;                  ///< Ширина уровня 0.
+  int height_;                 ///< Высота уровня 0.
+
+  /**
+   * @brief Число текселей во всей mip-цепочке текстуры width x height.
+   */
+  static size_t mipTexels(int width, int height);
+
+  /** @brief Число уровней mip-цепочки; 0 у пустой текстуры. */
+  int levels() const;
+
+  /**
+   * @brief Начало уровня level и его размер.
+   * @param level Номер уровня в [0, levels()).
+   * @param width Ширина уровня (возвращаемое значение).
+   * @param height Высота уровня (возвращаемое значение).
+   * @return Указатель на первый тексель уровня.
+   */
+  const Texel* level(int level, int& width, int& height) const;
 };
 
 /**
@@ -72,6 +95,40 @@ class MaterialManager {
    */
   uint32_t addMaterial(std::string& name, Material& material);
 
+  /**
+   * @brief Возвращает число материалов (вместе с дефолтным).
+   * @return Количество материалов; новый материал получит этот id.
+   */
+  uint32_t size() const;
+
+  /**
+   * @brief Ищет имя материала по идентификатору.
+   * @param idMaterial Идентификатор материала.
+   * @return Имя, под которым материал доступен, или пустая строка, если имя
+   * перекрыто более поздним материалом.
+   */
+  std::string getMaterialName(uint32_t idMaterial) const;
+
+  /**
+   * @brief Занимает id до firstFree копиями дефолтного материала.
+   *
+   * Так материалы, загруженные в отдельный менеджер, получают те же id, что
+   * и после merge в менеджер размера firstFree.
+   * @param firstFree Id, который получит следующий добавленный материал.
+   */
+  void reserveIds(uint32_t firstFree);
+
+  /**
+   * @brief Переносит сюда материалы другого менеджера, начиная с from.
+   *
+   * Имена, видимые в other, становятся видимыми здесь. Материал other с id
+   * k >= from получает id k - from + возвращённое значение.
+   * @param other Менеджер-источник; после вызова пуст.
+   * @param from Первый переносимый id (по умолчанию — всё, кроме дефолтного).
+   * @return Новый id первого перенесённого материала.
+   */
+  uint32_t merge(MaterialManager&& other, uint32_t from = 1);
+
  private:
   std::vector<Material> materials_;  ///< Вектор всех загруженных материалов.
   std::unordered_map<std::string, uint32_t>
@@ -0,0 +1,118 @@
+#ifndef MAPPED_VECTOR_H
+#define MAPPED_VECTOR_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace s21 {
+/**
+ * @class MappedVector
+ * @brief Массив в стиле std::vector, который либо владеет данными, либо
+ *        смотрит в чужую память (например, mmap бинарного кеша).
+ *
+ * Чужую память держит живой keepAlive. Копия такого массива — тоже ссылка,
+ * без копирования данных. Любой неконстантный доступ сначала переносит данные
+ * в собственный std::vector (copy-on-write). Перед параллельной записью
+ * массив надо отцепить заранее, из одного потока: вызвать detach() или взять
+ * неконстантный data().
+ */
+template <typename T>
+class MappedVector {
+ public:
+  using value_type = T;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  MappedVector() = default;
+
+  /** @brief Забирает готовый std::vector во владение. */
+  MappedVector(std::vector<T> values) : owned_(std::move(values)) {}
+
+  MappedVector& operator=(std::vector<T> values) {
+    owned_ = std::move(values);
+    releaseView();
+    return *this;
+  }
+
+  /**
+   * @brief Начинает смотреть в чужую память без копирования.
+   * @param data Начало массива.
+   * @param size Число элементов.
+   * @param keepAlive Владелец памяти; живёт, пока жив хоть один вид.
+   */
+  void adopt(const T* data, size_t size, std::shared_ptr<const void> keepAlive) {
+    owned_.clear();
+    owned_.shrink_to_fit();
+    view_ = data;
+    viewSize_ = size;
+    keepAlive_ = std::move(keepAlive);
+  }
+
+  /** @brief Смотрит ли массив в чужую память. */
+  bool isMapped() const { return keepAlive_ != nullptr; }
+
+  /** @brief Переносит данные в собственный буфер (для записи). */
+  void detach() {
+    if (!keepAlive_) return;
+    owned_.assign(view_, view_ + viewSize_);
+    releaseView();
+  }
+
+  size_t size() const { return keepAlive_ ? viewSize_ : owned_.size(); }
+  bool empty() const { return size() == 0; }
+  size_t capacity() const { return keepAlive_ ? viewSize_ : owned_.capacity(); }
+
+  const T* data() const { return keepAlive_ ? view_ : owned_.data(); }
+  T* data() {
+    detach();
+    return owned_.data();
+  }
+
+  const T& operator[](size_t i) const { return data()[i]; }
+  T& operator[](size_t i) {
+    detach();
+    return owned_[i];
+  }
+
+  const T* begin() const { return data(); }
+  const T* end() const { return data() + size(); }
+  T* begin() { return data(); }
+  T* end() { return data() + size(); }
+
+  void resize(size_t n) {
+    detach();
+    owned_.resize(n);
+  }
+  void reserve(size_t n) {
+    detach();
+    owned_.reserve(n);
+  }
+  void clear() {
+    owned_.clear();
+    releaseView();
+  }
+  void push_back(const T& value) {
+    detach();
+    owned_.push_back(value);
+  }
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    detach();
+    return owned_.emplace_back(std::forward<Args>(args)...);
+  }
+
+ private:
+  void releaseView() {
+    view_ = nullptr;
+    viewSize_ = 0;
+    keepAlive_.reset();
+  }
+
+  std::vector<T> owned_;  ///< Собственные данные (если не isMapped()).
+  const T* view_ = nullptr;  ///< Начало чужой памяти.
+  size_t viewSize_ = 0;      ///< Число элементов в чужой памяти.
+  std::shared_ptr<const void> keepAlive_;  ///< Владелец чужой памяти.
+};
+}  // namespace s21
+#endif  // MAPPED_VECTOR_H
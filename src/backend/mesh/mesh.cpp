@@ -1,5 +1,7 @@
 #include "mesh.h"
 
+#include <utility>
+
 namespace s21 {
 void Mesh::addVertex(Vertex v) { vertices_.push_back(v); }
 
@@ -15,4 +17,40 @@ void Mesh::addUVCoordinate(UVCoordinate uv, bool normalize) {
 }
 
 void Mesh::addFace(Face face) { faces_.push_back(face); }
+
+void Mesh::detach() {
+  vertices_.detach();
+  normals_.detach();
+  uvCoordinates_.detach();
+  faces_.detach();
+  facePlanes_.detach();
+}
+
+void Mesh::remapMaterials(uint32_t from, uint32_t to) {
+  if (from == to) return;
+  Face* faces = faces_.data();  // отцепляет массив от кеша до параллельной записи
+  const long long count = static_cast<long long>(faces_.size());
+#pragma omp parallel for
+  for (long long i = 0; i < count; ++i) {
+    uint32_t& index = faces[i].materialIndex;
+    if (index != 0) index = index - from + to;
+  }
+}
+
+void Mesh::computeFacePlanes(size_t from) {
+  const long long count = static_cast<long long>(faces_.size());
+  facePlanes_.resize(count);
+  Plane* planes = facePlanes_.data();
+  // Только чтение: вершины и грани могут остаться видом на кеш.
+  const Face* faces = std::as_const(faces_).data();
+  const Vertex* vertices = std::as_const(vertices_).data();
+#pragma omp parallel for
+  for (long long i = static_cast<long long>(from); i < count; ++i) {
+    const Vector3F v0 = vertices[faces[i].vertexIndex[0]].head<3>();
+    const Vector3F v1 = vertices[faces[i].vertexIndex[1]].head<3>();
+    const Vector3F v2 = vertices[faces[i].vertexIndex[2]].head<3>();
+    const Vector3F n = (v1 - v0).cross(v2 - v0).normalized();
+    planes[i] << n, -n.dot(v0);
+  }
+}
 }  // namespace s21
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <iostream>
 
+#include "backend/mesh/mappedVector.h"
 #include "backend/types.h"
 
 namespace s21 {
@@ -11,6 +12,9 @@ namespace s21 {
  * @class Mesh
  * @brief Класс, представляющий 3D-модель с вершинами, нормалями и текстурными
  * координатами.
+ *
+ * Массивы могут смотреть прямо в отображённый бинарный кеш (см. MeshCache);
+ * копия такого меша данные не копирует.
  */
 class Mesh {
  public:
@@ -39,11 +43,36 @@ class Mesh {
    */
   void addFace(Face face);
 
+  /**
+   * @brief Переносит все массивы в собственную память, если они смотрят в
+   * кеш. Вызывать из одного потока до параллельной записи в меш.
+   */
+  void detach();
+
+  /**
+   * @brief Сдвигает индексы материалов граней (кроме дефолтного 0):
+   * id >= from становится id - from + to. Нужно, когда материалы меша
+   * переносятся в другой менеджер.
+   * @param from Первый id материала меша в старом менеджере.
+   * @param to Первый id тех же материалов в новом менеджере.
+   */
+  void remapMaterials(uint32_t from, uint32_t to);
+
+  /**
+   * @brief Считает плоскости граней [from, faces_.size()) по вершинам меша.
+   *
+   * Нормаль плоскости единичная и смотрит туда, откуда обход вершин грани
+   * виден против часовой стрелки. У вырожденной грани плоскость нулевая.
+   * @param from Первая грань без плоскости (превью дописывает грани порциями).
+   */
+  void computeFacePlanes(size_t from = 0);
+
  public:
-  std::vector<Vertex> vertices_;  ///< Вектор вершин меша.
-  std::vector<Normal> normals_;   ///< Вектор нормалей меша.
-  std::vector<UVCoordinate> uvCoordinates_;  ///< Вектор координат UV меша.
-  std::vector<Face> faces_;  ///< Вектор граней меша.
+  MappedVector<Vertex> vertices_;  ///< Вектор вершин меша.
+  MappedVector<Normal> normals_;   ///< Вектор нормалей меша.
+  MappedVector<UVCoordinate> uvCoordinates_;  ///< Вектор координат UV меша.
+  MappedVector<Face> faces_;  ///< Вектор граней меша.
+  MappedVector<Plane> facePlanes_;  ///< Плоскости граней (computeFacePlanes).
 };
 }  // namespace s21
 #endif  // MESH_H
\ No newline at end of file
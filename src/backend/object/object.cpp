@@ -1,11 +1,15 @@
 #include "object.h"
 
 namespace s21 {
-void Object::setMesh(const Mesh& mesh) { mesh_ = mesh; }
+void Object::setMesh(std::shared_ptr<const Mesh> mesh) {
+  mesh_ = std::move(mesh);
+}
 
-const Mesh& Object::getMesh() const { return mesh_; }
+const Mesh& Object::getMesh() const { return *mesh_; }
 
-Mesh& Object::getMesh() { return mesh_; }
+const std::shared_ptr<const Mesh>& Object::getSharedMesh() const {
+  return mesh_;
+}
 
 void Object::setTransform(const Transform& transform) {
   transform_ = transform;
@@ -1,5 +1,7 @@
 #ifndef OBJECT_H
 #define OBJECT_H
+#include <memory>
+
 #include "backend/mesh/mesh.h"
 #include "backend/transform/transform.h"
 
@@ -7,6 +9,9 @@ namespace s21 {
 /**
  * @class Object
  * @brief Класс, представляющий 3D-объект с геометрией и трансформациями.
+ *
+ * Меш общий и неизменяемый: копии объекта делят его по счётчику ссылок,
+ * всё, что зависит от кадра, рендер держит в своих буферах.
  */
 class Object {
  public:
@@ -14,14 +19,15 @@ class Object {
    * @brief Конструктор объекта.
    * @param mesh Сетка (меш), связанная с объектом.
    */
-  Object(Mesh& mesh) : mesh_(mesh), transform_{} {}
+  explicit Object(std::shared_ptr<const Mesh> mesh)
+      : mesh_(std::move(mesh)), transform_{} {}
 
  public:
   /**
    * @brief Устанавливает новую сетку для объекта.
    * @param mesh Новая сетка.
    */
-  void setMesh(const Mesh& mesh);
+  void setMesh(std::shared_ptr<const Mesh> mesh);
 
   /**
    * @brief Возвращает константную ссылку на сетку объекта.
@@ -30,10 +36,10 @@ class Object {
   const Mesh& getMesh() const;
 
   /**
-   * @brief Возвращает ссылку на сетку объекта.
-   * @return Ссылка на Mesh.
+   * @brief Возвращает владеющий указатель на сетку.
+   * @return Указатель, по которому сетку можно опознать между кадрами.
    */
-  Mesh& getMesh();
+  const std::shared_ptr<const Mesh>& getSharedMesh() const;
 
   /**
    * @brief Устанавливает трансформацию объекта.
@@ -77,7 +83,7 @@ class Object {
   void scale(float sx, float sy, float sz);
 
  private:
-  Mesh mesh_;            ///< Сетка (меш) объекта.
+  std::shared_ptr<const Mesh> mesh_;  ///< Сетка (меш) объекта.
   Transform transform_;  ///< Трансформация объекта.
 };
 }  // namespace s21
@@ -0,0 +1,92 @@
+#ifndef RENDER_EDGE_FUNCTION_H
+#define RENDER_EDGE_FUNCTION_H
+
+#include <algorithm>
+#include <cstdint>
+
+namespace s21 {
+// Субпиксельная точность растеризатора: вершины округляются до 1/16 пикселя.
+constexpr int kSubpixelBits = 4;
+constexpr float kSubpixelScale = 1 << kSubpixelBits;
+constexpr int64_t kSubpixelHalf = 1 << (kSubpixelBits - 1);
+
+/**
+ * @brief Экранная координата -> фиксированная точка, с округлением от нуля,
+ * как std::llround, но без вызова libm (он стоит заметно на каждую вершину).
+ */
+inline int64_t toFixed(float v) {
+  const float scaled = v * kSubpixelScale;
+  return static_cast<int64_t>(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+}
+
+/** @brief Номер пикселя, в котором лежит координата в фиксированной точке. */
+inline int floorToPixel(int64_t fixed) {
+  return static_cast<int>(fixed >> kSubpixelBits);
+}
+
+/**
+ * @struct PixelBounds
+ * @brief Прямоугольник пикселей [minX, maxX] x [minY, maxY]; пуст, если
+ * minX > maxX или minY > maxY.
+ */
+struct PixelBounds {
+  int minX, minY, maxX, maxY;
+
+  bool empty() const { return minX > maxX || minY > maxY; }
+};
+
+/**
+ * @brief Пиксели, которые может задеть треугольник с вершинами (fx, fy) в
+ * фиксированной точке, в пределах экрана width x height. По нему и
+ * распределяются треугольники по плиткам, и выбираются строки растеризации.
+ */
+inline PixelBounds pixelBounds(const int64_t fx[3], const int64_t fy[3],
+                               int width, int height) {
+  return {std::max(0, floorToPixel(std::min({fx[0], fx[1], fx[2]}))),
+          std::max(0, floorToPixel(std::min({fy[0], fy[1], fy[2]}))),
+          std::min(width - 1, floorToPixel(std::max({fx[0], fx[1], fx[2]}))),
+          std::min(height - 1, floorToPixel(std::max({fy[0], fy[1], fy[2]})))};
+}
+
+/**
+ * @struct EdgeFunction
+ * @brief Уравнение ребра a -> b в фиксированной точке: E(p) = A*x + B*y + C,
+ * для точек внутри треугольника (площадь > 0) E >= 0. Значения
+ * пересчитываются приращениями на пиксель, без умножений.
+ */
+struct EdgeFunction {
+  int64_t a, b, c;
+  int64_t stepX, stepY;  ///< Приращения E на пиксель по x и по y.
+  /// Правило верхнего-левого ребра: на левых и верхних рёбрах пиксель
+  /// рисуется, на остальных — нет, поэтому у общих рёбер соседних
+  /// треугольников каждый пиксель закрашивается ровно один раз.
+  int64_t bias;
+
+  EdgeFunction(int64_t ax, int64_t ay, int64_t bx, int64_t by)
+      : a(ay - by),
+        b(bx - ax),
+        c(ax * by - ay * bx),
+        stepX(a << kSubpixelBits),
+        stepY(b << kSubpixelBits),
+        bias(a > 0 || (a == 0 && b > 0) ? 0 : -1) {}
+
+  /// Значение с поправкой правила заливки: пиксель внутри, если оно >= 0.
+  int64_t at(int64_t x, int64_t y) const { return a * x + b * y + c + bias; }
+};
+
+/**
+ * @brief Сужает [lo, hi) до шагов t (от опорного пикселя), где
+ * e + t * step >= 0. Пересечение таких отрезков по трём рёбрам — покрытые
+ * пиксели строки.
+ */
+inline void coveredSteps(int64_t e, int64_t step, int64_t& lo, int64_t& hi) {
+  if (step > 0) {
+    if (e < 0) lo = std::max(lo, (-e + step - 1) / step);
+  } else if (e < 0) {
+    hi = lo;  // значение только убывает — покрытия нет
+  } else if (step < 0) {
+    hi = std::min(hi, e / -step + 1);
+  }
+}
+}  // namespace s21
+#endif  // RENDER_EDGE_FUNCTION_H
@@ -0,0 +1,101 @@
+#ifndef RENDER_FRAME_ARENA_H
+#define RENDER_FRAME_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace s21 {
+/**
+ * @class FrameArena
+ * @brief Линейный (bump) аллокатор временных данных кадра.
+ *
+ * Память раздаётся подряд из одного блока и освобождается вся сразу в
+ * reset() в начале кадра. Если кадру не хватило блока, берутся добавочные
+ * блоки, а reset() сливает их в один блок по максимуму запроса. Поэтому,
+ * когда сцена перестаёт расти, кадр не обращается к куче вовсе.
+ *
+ * Выделение не потокобезопасно: участки для потоков берутся до входа в
+ * параллельную область.
+ */
+class FrameArena {
+ public:
+  /**
+   * @brief Освобождает всё выделенное за кадр.
+   *
+   * Если в прошлом кадре были добавочные блоки, основной блок
+   * перевыделяется под весь запрошенный объём.
+   */
+  void reset() {
+    if (!overflow_.empty()) {
+      size_t need = peak_;
+      overflow_.clear();
+      block_ = allocateBlock(need);
+      capacity_ = need;
+      allocations_++;
+    }
+    used_ = 0;
+    requested_ = 0;
+  }
+
+  /**
+   * @brief Выделяет неинициализированный массив до следующего reset().
+   * @param count Число элементов.
+   * @return Указатель на массив, выровненный по 64 байта.
+   */
+  template <typename T>
+  T* allocate(size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "деструкторы для памяти арены не вызываются");
+    size_t bytes = alignUp(count * sizeof(T));
+    requested_ += bytes;
+    peak_ = std::max(peak_, requested_);
+    if (used_ + bytes <= capacity_) {
+      T* out = reinterpret_cast<T*>(block_.get() + used_);
+      used_ += bytes;
+      return out;
+    }
+    overflow_.push_back(allocateBlock(bytes));
+    allocations_++;
+    return reinterpret_cast<T*>(overflow_.back().get());
+  }
+
+  /** @brief Сколько раз арена обращалась к куче за всё время. */
+  size_t allocations() const { return allocations_; }
+
+  /** @brief Размер основного блока в байтах. */
+  size_t capacity() const { return capacity_; }
+
+ private:
+  static constexpr size_t kAlign = 64;  ///< Выравнивание участков (кеш-линия).
+
+  static size_t alignUp(size_t bytes) {
+    return (bytes + kAlign - 1) / kAlign * kAlign;
+  }
+
+  /** Блок, выровненный по кеш-линии. */
+  struct AlignedDelete {
+    void operator()(std::byte* p) const {
+      ::operator delete[](p, std::align_val_t{kAlign});
+    }
+  };
+  using Block = std::unique_ptr<std::byte[], AlignedDelete>;
+
+  static Block allocateBlock(size_t bytes) {
+    return Block(static_cast<std::byte*>(
+        ::operator new[](bytes, std::align_val_t{kAlign})));
+  }
+
+  Block block_;                  ///< Основной блок.
+  size_t capacity_ = 0;          ///< Размер основного блока.
+  size_t used_ = 0;              ///< Занято в основном блоке.
+  size_t requested_ = 0;         ///< Запрошено за кадр (с добавочными).
+  size_t peak_ = 0;              ///< Максимум requested_ за всё время.
+  std::vector<Block> overflow_;  ///< Добавочные блоки текущего кадра.
+  size_t allocations_ = 0;       ///< Обращений к куче.
+};
+}  // namespace s21
+#endif  // RENDER_FRAME_ARENA_H
@@ -0,0 +1,193 @@
+#include "framebuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+namespace s21 {
+Framebuffer::Framebuffer(int width, int height, DepthFormat format)
+    : format_(format) {
+  resize(width, height);
+}
+
+void Framebuffer::resize(int width, int height) {
+  width_ = std::max(width, 0);
+  height_ = std::max(height, 0);
+  tilesX_ = (width_ + kTileSize - 1) / kTileSize;
+  tilesY_ = (height_ + kTileSize - 1) / kTileSize;
+  const size_t pixels = static_cast<size_t>(tilesX_) * tilesY_ * kTilePixels;
+  reserve(color_, colorCapacity_, pixels * sizeof(uint32_t));
+  reserve(depth_, depthCapacity_, pixels * depthBytes(format_));
+  if (visibility_) {
+    reserve(triangles_, trianglesCapacity_, pixels * sizeof(uint32_t));
+    reserve(weights_, weightsCapacity_, pixels * 2 * sizeof(float));
+  }
+
+  // Содержимое плоскостей больше не соответствует кадру: все плитки — фон.
+  const int tiles = tilesX_ * tilesY_;
+  if (tiles > tileCapacity_) {
+    tileEpoch_.reset(new std::atomic<uint32_t>[tiles]);
+    hiZ_.reset(new TileHiZ[tiles]);
+    tileCapacity_ = tiles;
+    allocations_ += 2;
+  }
+  for (int tile = 0; tile < tiles; ++tile) tileEpoch_[tile].store(0);
+}
+
+void Framebuffer::setDepthFormat(DepthFormat format) {
+  format_ = format;
+  resize(width_, height_);
+}
+
+void Framebuffer::setVisibilityBuffer(bool enabled) {
+  visibility_ = enabled;
+  resize(width_, height_);
+}
+
+void Framebuffer::reserve(Plane& plane, size_t& capacity, size_t bytes) {
+  if (bytes <= capacity) return;
+  plane = Plane(static_cast<std::byte*>(
+      ::operator new[](bytes, std::align_val_t{kAlign})));
+  capacity = bytes;
+  allocations_++;
+}
+
+void Framebuffer::clear(uint32_t color) {
+  clearColor_ = color;
+  if (++epoch_ == kClearing) {  // счётчик кадров обернулся
+    epoch_ = 1;
+    for (int tile = 0; tile < tilesX_ * tilesY_; ++tile) {
+      tileEpoch_[tile].store(0);
+    }
+  }
+}
+
+void Framebuffer::clearTile(int tile) {
+  std::atomic<uint32_t>& state = tileEpoch_[tile];
+  uint32_t seen = state.load(std::memory_order_acquire);
+  while (seen != epoch_) {
+    if (seen == kClearing) {  // заливает другой поток — ждём его
+      std::this_thread::yield();
+      seen = state.load(std::memory_order_acquire);
+      continue;
+    }
+    if (!state.compare_exchange_weak(seen, kClearing,
+                                     std::memory_order_acquire)) {
+      continue;
+    }
+
+    std::fill_n(colorTile(tile), kTilePixels, clearColor_);
+    void* depth = depthTile(tile);
+    switch (format_) {
+      case DepthFormat::Float32:
+        std::fill_n(static_cast<float*>(depth), kTilePixels, 1.0f);
+        break;
+      case DepthFormat::Unorm24:
+        std::fill_n(static_cast<uint32_t*>(depth), kTilePixels, 0xFFFFFFu);
+        break;
+      case DepthFormat::Unorm16:
+        std::fill_n(static_cast<uint16_t*>(depth), kTilePixels,
+                    uint16_t{0xFFFF});
+        break;
+    }
+    if (visibility_) std::fill_n(triangleTile(tile), kTilePixels, kNoTriangle);
+    TileHiZ& hiZ = hiZ_[tile];
+    hiZ.tileMax = 1.0f;
+    std::fill(std::begin(hiZ.written), std::end(hiZ.written), 0);
+    std::fill(std::begin(hiZ.pending), std::end(hiZ.pending), 0);
+    std::fill(std::begin(hiZ.blockMax), std::end(hiZ.blockMax), 1.0f);
+    state.store(epoch_, std::memory_order_release);
+    return;
+  }
+}
+
+void Framebuffer::commitCoverage(int tile, uint64_t blocks, float farthest) {
+  TileHiZ& hiZ = hiZ_[tile];
+  bool lowered = false;
+  for (; blocks != 0; blocks &= blocks - 1) {
+    const int block = __builtin_ctzll(blocks);
+    // Пока в блоке есть пиксели фона, оценка — дальняя плоскость; после —
+    // её может понизить только треугольник, целиком ближе неё. Пересчёт —
+    // не чаще раза на блок записанных пикселей.
+    if (hiZ.written[block] != ~uint64_t{0} ||
+        hiZ.pending[block] < kBlockSize * kBlockSize ||
+        farthest >= hiZ.blockMax[block]) {
+      continue;
+    }
+    hiZ.pending[block] = 0;
+    const float blockMax = depthMax(tile, block);
+    if (blockMax < hiZ.blockMax[block]) {
+      lowered |= hiZ.blockMax[block] == hiZ.tileMax;
+      hiZ.blockMax[block] = blockMax;
+    }
+  }
+  if (lowered) {
+    hiZ.tileMax =
+        *std::max_element(std::begin(hiZ.blockMax), std::end(hiZ.blockMax));
+  }
+}
+
+float Framebuffer::depthMax(int tile, int block) {
+  const int origin = block / kTileBlocks * kBlockSize * kTileSize +
+                     block % kTileBlocks * kBlockSize;
+  // Целые форматы округляют глубину вниз: сверху её ограничивает следующий
+  // уровень квантования.
+  auto unormMax = [&](const auto* depth, float max) {
+    uint32_t farthest = 0;
+    for (int y = 0; y < kBlockSize; ++y) {
+      for (int x = 0; x < kBlockSize; ++x) {
+        farthest = std::max<uint32_t>(farthest, depth[y * kTileSize + x]);
+      }
+    }
+    return (static_cast<float>(farthest) + 1.0f) / max * 2.0f - 1.0f;
+  };
+  switch (format_) {
+    case DepthFormat::Unorm24:
+      return unormMax(static_cast<const uint32_t*>(depthTile(tile)) + origin,
+                      16777215.0f);
+    case DepthFormat::Unorm16:
+      return unormMax(static_cast<const uint16_t*>(depthTile(tile)) + origin,
+                      65535.0f);
+    case DepthFormat::Float32:
+      break;
+  }
+  const float* depth = static_cast<const float*>(depthTile(tile)) + origin;
+  float farthest = -1.0f;
+  for (int y = 0; y < kBlockSize; ++y) {
+    for (int x = 0; x < kBlockSize; ++x) {
+      farthest = std::max(farthest, depth[y * kTileSize + x]);
+    }
+  }
+  return farthest;
+}
+
+size_t Framebuffer::coveredPixels() const {
+  size_t covered = 0;
+  for (int tile = 0; tile < tilesX_ * tilesY_; ++tile) {
+    if (isCleared(tile)) continue;
+    for (uint64_t written : hiZ_[tile].written) {
+      covered += __builtin_popcountll(written);
+    }
+  }
+  return covered;
+}
+
+void Framebuffer::resolve(unsigned char* bits,
+                          std::ptrdiff_t bytesPerLine) const {
+  // Строка изображения собирается из строк плиток, по kTileSize пикселей;
+  // за нетронутые плитки пишется фон.
+#pragma omp parallel for
+  for (int y = 0; y < height_; ++y) {
+    uint32_t* line = reinterpret_cast<uint32_t*>(bits + y * bytesPerLine);
+    for (int x = 0; x < width_; x += kTileSize) {
+      const int count = std::min(kTileSize, width_ - x);
+      if (isCleared(tileOf(x, y))) {
+        std::fill_n(line + x, count, clearColor_);
+      } else {
+        std::memcpy(line + x, colorAt(x, y), count * sizeof(uint32_t));
+      }
+    }
+  }
+}
+}  // namespace s21
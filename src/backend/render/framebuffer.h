@@ -0,0 +1,314 @@
+#ifndef RENDER_FRAMEBUFFER_H
+#define RENDER_FRAMEBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace s21 {
+/**
+ * @enum DepthFormat
+ * @brief Формат хранения глубины.
+ *
+ * Unorm-форматы хранят глубину NDC [-1, 1], переведённую в [0, 1] и
+ * квантованную: 24 бита — в 32-битном слове, 16 бит — вдвое меньше памяти
+ * ценой точности вдали от камеры.
+ */
+enum class DepthFormat : uint8_t {
+  Float32,  ///< float, как есть (по умолчанию).
+  Unorm24,  ///< 24-битное целое в uint32_t.
+  Unorm16,  ///< 16-битное целое в uint16_t.
+};
+
+/**
+ * @class Framebuffer
+ * @brief Цвет ARGB32 и глубина кадра, разложенные по плиткам.
+ *
+ * Кадр делится на плитки kTileSize x kTileSize; каждая плитка лежит в
+ * памяти одним непрерывным куском, строки внутри неё — подряд. Так пиксели
+ * одной плитки растеризатора занимают один участок памяти и в цвете, и в
+ * глубине, а строка плитки — непрерывный отрезок для SIMD. Плоскости
+ * выровнены по 64 байта; плитки на краю кадра хранятся целиком.
+ *
+ * Очистка ленивая: clear() лишь начинает новый кадр (эпоху). Плитка
+ * заливается фоном и дальней глубиной при первой записи в этом кадре —
+ * prepareTile(), — а плитки, которых кадр не коснулся, получают фон прямо
+ * в resolve(), не трогая плоскостей. Изменение размера перевыделяет память,
+ * только если плиток стало больше, чем помещалось. В изображение для показа
+ * кадр переписывается один раз — resolve().
+ *
+ * Буфер видимости (setVisibilityBuffer()) добавляет плоскости номера
+ * треугольника и весов его вершин 1 и 2: растеризатор пишет их вместо цвета,
+ * а закрашивает пиксели потом, уже только видимые.
+ *
+ * Иерархическая глубина: для каждого блока kBlockSize x kBlockSize и каждой
+ * плитки хранится верхняя оценка глубины. За кадр глубина только убывает,
+ * поэтому устаревшая оценка остаётся верной. Блок копит маску пикселей,
+ * записанных в этом кадре; когда она заполнена, оценку пересчитывает по
+ * плоскости глубины треугольник, который целиком ближе неё, — тот, что мог
+ * её понизить. Блок 8x8 лежит в плитке, уже горячей в кэше.
+ */
+class Framebuffer {
+ public:
+  static constexpr int kTileSize = 64;  ///< Сторона плитки в пикселях.
+  static constexpr int kTilePixels = kTileSize * kTileSize;
+  static constexpr int kBlockSize = 8;  ///< Сторона блока глубины.
+  static constexpr int kTileBlocks = kTileSize / kBlockSize;  ///< В стороне.
+  /// Номер треугольника пикселя, в который треугольник не писал.
+  static constexpr uint32_t kNoTriangle = ~uint32_t{0};
+
+  /**
+   * @brief Создаёт буфер кадра.
+   * @param width Ширина в пикселях.
+   * @param height Высота в пикселях.
+   * @param format Формат глубины.
+   */
+  Framebuffer(int width, int height, DepthFormat format = DepthFormat::Float32);
+
+  /**
+   * @brief Меняет размер. Содержимое после вызова не определено.
+   */
+  void resize(int width, int height);
+
+  /**
+   * @brief Меняет формат глубины. Глубина после вызова не определена.
+   */
+  void setDepthFormat(DepthFormat format);
+
+  /**
+   * @brief Включает плоскости буфера видимости. Содержимое после вызова не
+   * определено.
+   */
+  void setVisibilityBuffer(bool enabled);
+
+  /**
+   * @brief Начинает кадр: цвет — color, глубина — дальняя плоскость.
+   *
+   * Памяти не касается; плитки очищаются в prepareTile() или resolve().
+   * @param color Цвет ARGB32.
+   */
+  void clear(uint32_t color);
+
+  /**
+   * @brief Готовит плитку к записи: если в этом кадре её ещё не трогали,
+   * заливает её цвет и глубину, а номера треугольников — kNoTriangle.
+   * Потокобезопасна; вызывать перед записью через colorTile(), depthTile()
+   * и triangleTile().
+   */
+  void prepareTile(int tile) {
+    if (tileEpoch_[tile].load(std::memory_order_acquire) != epoch_) {
+      clearTile(tile);
+    }
+  }
+
+  /**
+   * @brief Переписывает кадр в изображение построчно.
+   * @param bits Первый байт изображения ARGB32 размера width() x height().
+   * @param bytesPerLine Шаг строк изображения в байтах.
+   */
+  void resolve(unsigned char* bits, std::ptrdiff_t bytesPerLine) const;
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int tilesX() const { return tilesX_; }
+  int tilesY() const { return tilesY_; }
+  DepthFormat depthFormat() const { return format_; }
+  bool visibilityBuffer() const { return visibility_; }
+
+  /** @brief Плитку в этом кадре не трогали — она целиком цвета фона. */
+  bool isCleared(int tile) const {
+    return tileEpoch_[tile].load(std::memory_order_acquire) != epoch_;
+  }
+
+  /** @brief Цвет плитки tile (tileY * tilesX() + tileX), строки подряд. */
+  uint32_t* colorTile(int tile) {
+    return reinterpret_cast<uint32_t*>(color_.get()) +
+           static_cast<size_t>(tile) * kTilePixels;
+  }
+
+  /** @brief Глубина плитки tile в формате depthFormat(), строки подряд. */
+  void* depthTile(int tile) {
+    return depth_.get() +
+           static_cast<size_t>(tile) * kTilePixels * depthBytes(format_);
+  }
+
+  /**
+   * @brief Номера треугольников плитки, строки подряд. Только с буфером
+   * видимости.
+   */
+  uint32_t* triangleTile(int tile) {
+    return reinterpret_cast<uint32_t*>(triangles_.get()) +
+           static_cast<size_t>(tile) * kTilePixels;
+  }
+
+  /**
+   * @brief Веса вершины k + 1 (k — 0 или 1) в пикселях плитки, строки
+   * подряд. Только с буфером видимости.
+   */
+  float* weightTile(int tile, int k) {
+    return reinterpret_cast<float*>(weights_.get()) +
+           (static_cast<size_t>(tile) * 2 + k) * kTilePixels;
+  }
+
+  /**
+   * @brief Какие блоки плитки в прямоугольнике [bx0, bx1] x [by0, by1]
+   * (в блоках от угла плитки) целиком ближе depth: ничто с глубиной >= depth
+   * там не пройдёт тест глубины. Бит блока — by * kTileBlocks + bx.
+   *
+   * Плитка должна быть подготовлена; вызывать из потока, который в неё
+   * пишет (как и два метода ниже).
+   */
+  uint64_t occludedBlocks(int tile, int bx0, int by0, int bx1, int by1,
+                          float depth) const {
+    const TileHiZ& hiZ = hiZ_[tile];
+    const uint64_t rect = blockMask(bx0, by0, bx1, by1);
+    if (depth >= hiZ.tileMax) return rect;
+    uint64_t occluded = 0;
+    for (uint64_t blocks = rect; blocks != 0; blocks &= blocks - 1) {
+      const int block = __builtin_ctzll(blocks);
+      if (depth >= hiZ.blockMax[block]) occluded |= uint64_t{1} << block;
+    }
+    return occluded;
+  }
+
+  /**
+   * @brief Отмечает пиксели [xBegin, xEnd) строки y плитки (от её угла) как
+   * записанные текущим треугольником.
+   * @return Маска задетых блоков.
+   */
+  uint64_t coverSpan(int tile, int y, int xBegin, int xEnd) {
+    TileHiZ& hiZ = hiZ_[tile];
+    const int rowShift = y % kBlockSize * kBlockSize;
+    const int blockRow = y / kBlockSize * kTileBlocks;
+    uint64_t blocks = 0;
+    for (int bx = xBegin / kBlockSize; bx * kBlockSize < xEnd; ++bx) {
+      const int lo = std::max(xBegin - bx * kBlockSize, 0);
+      const int hi = std::min(xEnd - bx * kBlockSize, kBlockSize);
+      const uint64_t bits = (1u << hi) - (1u << lo);
+      hiZ.written[blockRow + bx] |= bits << rowShift;
+      hiZ.pending[blockRow + bx] += hi - lo;
+      blocks |= uint64_t{1} << (blockRow + bx);
+    }
+    return blocks;
+  }
+
+  /**
+   * @brief Завершает треугольник, писавший в блоки blocks (см. coverSpan()),
+   * с глубиной не дальше farthest: пересчитывает оценки, которые он мог
+   * понизить.
+   */
+  void commitCoverage(int tile, uint64_t blocks, float farthest);
+
+  /** @brief Маска блоков прямоугольника [bx0, bx1] x [by0, by1]. */
+  static uint64_t blockMask(int bx0, int by0, int bx1, int by1) {
+    const uint64_t row = (uint64_t{2} << bx1) - (uint64_t{1} << bx0);
+    uint64_t mask = 0;
+    for (int by = by0; by <= by1; ++by) mask |= row << (by * kTileBlocks);
+    return mask;
+  }
+
+  /** @brief Цвет пикселя (x, y); координаты должны быть внутри кадра. */
+  uint32_t pixel(int x, int y) const {
+    return isCleared(tileOf(x, y)) ? clearColor_ : *colorAt(x, y);
+  }
+
+  /**
+   * @brief Пишет цвет пикселя поверх треугольника: в буфере видимости
+   * пиксель больше не закрашивается. Точки вне кадра пропускаются.
+   */
+  void setPixel(int x, int y, uint32_t color) {
+    if (x < 0 || y < 0 || x >= width_ || y >= height_) return;
+    const int tile = tileOf(x, y);
+    prepareTile(tile);
+    const size_t offset = static_cast<size_t>(tile) * kTilePixels +
+                          y % kTileSize * kTileSize + x % kTileSize;
+    reinterpret_cast<uint32_t*>(color_.get())[offset] = color;
+    if (visibility_) {
+      reinterpret_cast<uint32_t*>(triangles_.get())[offset] = kNoTriangle;
+    }
+  }
+
+  /**
+   * @brief Сколько пикселей кадра покрыли грани: по битам записи
+   * иерархической глубины (coverSpan()).
+   */
+  size_t coveredPixels() const;
+
+  /** @brief Сколько раз буфер обращался к куче за всё время. */
+  size_t allocations() const { return allocations_; }
+
+  /** @brief Байт на значение глубины в формате format. */
+  static size_t depthBytes(DepthFormat format) {
+    return format == DepthFormat::Unorm16 ? 2 : 4;
+  }
+
+ private:
+  static constexpr size_t kAlign = 64;  ///< Выравнивание плоскостей.
+
+  struct AlignedDelete {
+    void operator()(std::byte* p) const {
+      ::operator delete[](p, std::align_val_t{kAlign});
+    }
+  };
+  using Plane = std::unique_ptr<std::byte[], AlignedDelete>;
+
+  static constexpr int kBlocks = kTileBlocks * kTileBlocks;
+
+  /** Иерархическая глубина плитки: верхние оценки глубины NDC. */
+  struct TileHiZ {
+    float tileMax;              ///< Оценка по всей плитке.
+    float blockMax[kBlocks];    ///< Оценки блоков.
+    uint64_t written[kBlocks];  ///< Пиксели блока, записанные в кадре.
+    int pending[kBlocks];       ///< Записей в блок с пересчёта оценки.
+  };
+
+  // Эпоха плитки, которую сейчас заливает другой поток.
+  static constexpr uint32_t kClearing = ~uint32_t{0};
+
+  // Перевыделяет plane, если в неё не помещается bytes.
+  void reserve(Plane& plane, size_t& capacity, size_t bytes);
+
+  // Заливка плитки; из потоков, пришедших одновременно, льёт один.
+  void clearTile(int tile);
+
+  // Самая дальняя глубина блока в плоскости глубины, в NDC.
+  float depthMax(int tile, int block);
+
+  int tileOf(int x, int y) const {
+    return y / kTileSize * tilesX_ + x / kTileSize;
+  }
+
+  uint32_t* colorAt(int x, int y) const {
+    return reinterpret_cast<uint32_t*>(color_.get()) +
+           static_cast<size_t>(tileOf(x, y)) * kTilePixels +
+           y % kTileSize * kTileSize + x % kTileSize;
+  }
+
+  int width_ = 0;
+  int height_ = 0;
+  int tilesX_ = 0;
+  int tilesY_ = 0;
+  DepthFormat format_;
+  bool visibility_ = false;  ///< Есть ли плоскости буфера видимости.
+
+  Plane color_;                   ///< ARGB32, плитка за плиткой.
+  Plane depth_;                   ///< Глубина в формате format_.
+  Plane triangles_;               ///< Номера треугольников (видимость).
+  Plane weights_;                 ///< Веса вершин 1 и 2 (видимость).
+  size_t colorCapacity_ = 0;      ///< Размер color_ в байтах.
+  size_t depthCapacity_ = 0;      ///< Размер depth_ в байтах.
+  size_t trianglesCapacity_ = 0;  ///< Размер triangles_ в байтах.
+  size_t weightsCapacity_ = 0;    ///< Размер weights_ в байтах.
+  size_t allocations_ = 0;        ///< Обращений к куче.
+
+  uint32_t clearColor_ = 0;  ///< Цвет фона текущего кадра.
+  uint32_t epoch_ = 1;       ///< Номер кадра; 0 у плитки — «не трогали».
+  std::unique_ptr<std::atomic<uint32_t>[]> tileEpoch_;  ///< Кадр плитки.
+  std::unique_ptr<TileHiZ[]> hiZ_;  ///< Иерархическая глубина плиток.
+  int tileCapacity_ = 0;  ///< Размер tileEpoch_.
+};
+}  // namespace s21
+#endif  // RENDER_FRAMEBUFFER_H
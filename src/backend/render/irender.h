@@ -5,6 +5,7 @@
 #include <QImage>
 #include <vector>
 
+#include "backend/render/framebuffer.h"
 #include "backend/scene/scene.h"
 #include "backend/types.h"
 #include "renderSettings.hpp"
@@ -27,7 +28,7 @@ class IRender {
   IRender(RenderSettings& settings, int width = 800, int height = 600)
       : _frontBuffer(width, height, QImage::Format_ARGB32),
         _backBuffer(width, height, QImage::Format_ARGB32),
-        depthBuffer(width, std::vector<float>(height, 1.0f)),
+        _framebuffer(width, height),
         m_settings(settings) {
     _frontBuffer.fill(m_settings.fon_color);
     _backBuffer.fill(m_settings.fon_color);
@@ -47,6 +48,8 @@ class IRender {
 
   /**
    * @brief Изменяет размер буферов рендеринга.
+   *
+   * Буфер кадра перевыделяется, только если не хватает уже занятой памяти.
    * @param width Новая ширина буфера.
    * @param height Новая высота буфера.
    * @param fon_color Новый цвет фона (по умолчанию Qt::white).
@@ -57,9 +60,19 @@ class IRender {
     QMutexLocker frontLocker(&_frontBufferMutex);
     _frontBuffer = _frontBuffer.scaled(width, height, Qt::IgnoreAspectRatio,
                                        Qt::SmoothTransformation);
-    _backBuffer = QImage(width, height, QImage::Format_ARGB32);
-    depthBuffer = std::vector<std::vector<float>>(
-        width, std::vector<float>(height, 1.0f));
+    if (_backBuffer.width() != width || _backBuffer.height() != height) {
+      _backBuffer = QImage(width, height, QImage::Format_ARGB32);
+    }
+    _framebuffer.resize(width, height);
+  }
+
+  /**
+   * @brief Меняет формат буфера глубины.
+   * @param format Float32 (по умолчанию), Unorm24 или Unorm16.
+   */
+  void setDepthFormat(DepthFormat format) {
+    QMutexLocker backLocker(&_backBufferMutex);
+    _framebuffer.setDepthFormat(format);
   }
 
  public:
@@ -89,19 +102,23 @@ class IRender {
 
  protected:
   /**
-   * @brief Очищает изображение и буфер глубины.
+   * @brief Очищает цвет и глубину буфера кадра — лениво, по плиткам (см.
+   * Framebuffer::clear()).
    */
-  void clearImage() {
-    _backBuffer.fill(m_settings.fon_color);
-    for (auto& row : depthBuffer) {
-      std::fill(row.begin(), row.end(), 1.0f);
-    }
+  void clearImage() { _framebuffer.clear(QColor(m_settings.fon_color).rgba()); }
+
+  /**
+   * @brief Переписывает готовый кадр в задний буфер — раз за кадр, перед
+   * swapBuffers().
+   */
+  void resolveFrame() {
+    _framebuffer.resolve(_backBuffer.bits(), _backBuffer.bytesPerLine());
   }
 
  protected:
   QImage _frontBuffer;  ///< Передний буфер (то, что видит пользователь)
   QImage _backBuffer;  ///< Задний буфер (для рендеринга)
-  std::vector<std::vector<float>> depthBuffer;  ///< Буфер глубины
+  Framebuffer _framebuffer;  ///< Цвет и глубина кадра, по плиткам
 
   RenderSettings& m_settings;  ///< Настройки рендеринга
 
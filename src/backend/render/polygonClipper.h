@@ -0,0 +1,91 @@
+#ifndef RENDER_POLYGON_CLIPPER_H
+#define RENDER_POLYGON_CLIPPER_H
+
+#include "backend/types.h"
+
+namespace s21 {
+// Защитная полоса: по x/y треугольник режется, только если вылезает за
+// kGuardBand размеров экрана, остальное отрезает ограничивающий
+// прямоугольник растеризатора. Экранные координаты при этом остаются в
+// пределах нескольких экранов, и площадь треугольника считается без потери
+// точности.
+constexpr float kGuardBand = 4.0f;
+
+// Плоскости, по которым режет Сазерленд–Ходжмен: ближняя, дальняя и четыре
+// плоскости защитной полосы. Каждая добавляет не больше одной вершины.
+constexpr int kClipPlanes = 6;
+constexpr int kMaxClipVertices = 3 + kClipPlanes;
+
+/** @brief Вершина отсекаемого многоугольника со всеми атрибутами. */
+struct ClipVertex {
+  Vertex clip;
+  Vertex world;
+  Normal normal;
+  UVCoordinate uv;
+};
+
+/**
+ * @brief Расстояние до плоскости отсечения plane (0 — ближняя, 1 — дальняя,
+ * 2..5 — защитная полоса); вершина внутри, если оно >= 0.
+ */
+inline float planeDistance(const Vertex& v, int plane) {
+  switch (plane) {
+    case 0:
+      return v.z() + v.w();  // ближняя
+    case 1:
+      return v.w() - v.z();  // дальняя
+    case 2:
+      return kGuardBand * v.w() + v.x();
+    case 3:
+      return kGuardBand * v.w() - v.x();
+    case 4:
+      return kGuardBand * v.w() + v.y();
+    default:
+      return kGuardBand * v.w() - v.y();
+  }
+}
+
+/**
+ * @brief Один шаг Сазерленда–Ходжмена: атрибуты интерполируются линейно в
+ * clip space, до деления на w.
+ * @return Число вершин в out.
+ */
+inline int clipAgainstPlane(const ClipVertex* in, int count, ClipVertex* out,
+                            int plane) {
+  int written = 0;
+  for (int i = 0; i < count; i++) {
+    const ClipVertex& a = in[i];
+    const ClipVertex& b = in[(i + 1) % count];
+    const float da = planeDistance(a.clip, plane);
+    const float db = planeDistance(b.clip, plane);
+    if (da >= 0.0f) out[written++] = a;
+    if ((da >= 0.0f) != (db >= 0.0f)) {
+      const float t = da / (da - db);
+      out[written++] = {a.clip + t * (b.clip - a.clip),
+                        a.world + t * (b.world - a.world),
+                        a.normal + t * (b.normal - a.normal),
+                        a.uv + t * (b.uv - a.uv)};
+    }
+  }
+  return written;
+}
+
+/**
+ * @brief Режет треугольник polygon[0][0..2] всеми плоскостями по очереди,
+ * перекладывая вершины между двумя буферами.
+ * @param count Число вершин результата; меньше 3 — треугольник отсечён.
+ * @return Буфер с выпуклым многоугольником-результатом.
+ */
+inline const ClipVertex* clipTriangle(
+    ClipVertex (&polygon)[2][kMaxClipVertices], int& count) {
+  count = 3;
+  int current = 0;
+  for (int plane = 0; plane < kClipPlanes && count >= 3; plane++) {
+    count = clipAgainstPlane(polygon[current], count, polygon[1 - current],
+                             plane);
+    current = 1 - current;
+  }
+  return polygon[current];
+}
+}  // namespace s21
+#endif  // RENDER_POLYGON_CLIPPER_H
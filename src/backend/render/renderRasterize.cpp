@@ -1,11 +1,80 @@
 #include "renderRasterize.h"
 
+#include "backend/render/edgeFunction.h"
+#include "backend/render/polygonClipper.h"
+#include "backend/render/streamCompaction.h"
+
 #include <omp.h>
 #include <qdebug.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <numeric>
 
 namespace s21 {
+namespace {
+// Коды отсечения вершины (outcodes): за какими плоскостями она лежит в clip
+// space. Первые шесть — грани видимого объёма.
+constexpr uint8_t kOutLeft = 1 << 0;    // x < -w
+constexpr uint8_t kOutRight = 1 << 1;   // x > w
+constexpr uint8_t kOutBottom = 1 << 2;  // y < -w
+constexpr uint8_t kOutTop = 1 << 3;     // y > w
+constexpr uint8_t kOutNear = 1 << 4;    // z < -w
+constexpr uint8_t kOutFar = 1 << 5;     // z > w
+constexpr uint8_t kOutBehind = 1 << 6;  // w <= 0
+constexpr uint8_t kOutGuard = 1 << 7;   // |x| или |y| > kGuardBand * w
+
+constexpr uint8_t kOutFrustum =
+    kOutLeft | kOutRight | kOutBottom | kOutTop | kOutNear | kOutFar;
+constexpr uint8_t kOutNeedsClip = kOutNear | kOutFar | kOutBehind | kOutGuard;
+
+// Плитки растеризатора совпадают с плитками буфера кадра: цвет и глубина
+// плитки (2 x 16 КБ) лежат подряд и помещаются в L1/L2, пока по ней идут её
+// треугольники.
+constexpr int kTileSize = Framebuffer::kTileSize;
+constexpr int kBlockSize = Framebuffer::kBlockSize;
+constexpr int kTileBlocks = Framebuffer::kTileBlocks;
+
+// Запас иерархического теста глубины: глубина, интерполированная в пикселе,
+// из-за округления float может выйти чуть за пределы глубин вершин.
+constexpr float kHiZEpsilon = 1.0f / (1 << 18);
+
+// Треугольники объекта идут группами по kClusterSize подряд: в меше соседние
+// грани обычно рядом и в пространстве. Предпроход глубины обходит группы
+// плитки от ближних к дальним.
+constexpr uint32_t kClusterSize = 64;
+
+// Биты float, упорядоченные как сами числа.
+uint32_t orderedBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+/** Плитки, которые задевает треугольник: [x0, x1] x [y0, y1]. */
+struct TileRange {
+  uint16_t x0, y0, x1, y1;
+};
+
+// Плоскость атрибута для SpanSetup: значение в вершине 0 и приращения к
+// вершинам 1 и 2.
+void setPlane(float* out, float a0, float a1, float a2) {
+  out[0] = a0;
+  out[1] = a1 - a0;
+  out[2] = a2 - a0;
+}
+
+// Clip space -> экран: x, y в пикселях, z — глубина NDC, w сохраняется для
+// перспективной коррекции текстур.
+Vertex toScreen(const Vertex& clip, float halfW, float halfH) {
+  const float invW = 1.0f / clip.w();
+  return Vertex((clip.x() * invW + 1.0f) * halfW,
+                (1.0f - clip.y() * invW) * halfH, clip.z() * invW, clip.w());
+}
+}  // namespace
+
 RenderRasterize::RenderRasterize(RenderSettings& settings, int width, int hight)
     : IRender(settings, width, hight) {}
 
@@ -13,46 +82,144 @@ void RenderRasterize::rendering(Scene& scene) {
   auto frameStart = std::chrono::steady_clock::now();
 
   QMutexLocker locker(&_backBufferMutex);
+  const ShadingPipeline pipeline = framePipeline();
+  const bool faces = m_settings.renderFace;
+  const bool wire = m_settings.renderDot || m_settings.renderLine;
+  const bool visibility =
+      faces && pipeline == ShadingPipeline::VisibilityBuffer;
+  const bool prepass = faces && pipeline == ShadingPipeline::DepthPrepass;
+  if (_framebuffer.visibilityBuffer() != visibility) {
+    _framebuffer.setVisibilityBuffer(visibility);
+  }
   clearImage();
 
-  for (int i = 0; i < scene.getObjects().size(); i++) {
-    // Трансформируем один рабочий меш in-place. Мировые вершины держим отдельно:
-    // они ещё нужны для освещения, а work к тому моменту уже в clip space.
-    Object work = scene.getObjects()[i];
+  const size_t arenaAllocations = arena_.allocations();
+  arena_.reset();
+  frameAllocations_ = 0;
 
-    transformToWorldCoordinates(work, work);
-
-    std::vector<Vertex> worldVertex = work.getMesh().vertices_;
+  const auto& objects = scene.getObjects();
+  if (scratch_.size() < objects.size()) {
+    if (objects.size() > scratch_.capacity()) frameAllocations_++;
+    scratch_.resize(objects.size());
+  }
+  // Номера треугольников объекта i в кадре — с firstTriangle[i].
+  uint32_t* firstTriangle = arena_.allocate<uint32_t>(objects.size() + 1);
+  firstTriangle[0] = 0;
+  TileBins* bins = arena_.allocate<TileBins>(objects.size());
+  size_t shaded = 0;  // пикселей, прошедших тест глубины в исходном порядке
+
+  for (size_t i = 0; i < objects.size(); i++) {
+    // Меш общий и только читается. Всё производное от кадра пишем в буферы
+    // объекта; мировые вершины и нормали камеры нужны только освещению.
+    const Object& object = objects[i];
+    const Mesh& mesh = object.getMesh();
+    ObjectScratch& s = scratch_[i];
+    const bool lighting = m_settings.renderFace;
 
     Camera& camera = *scene.getCurrentCamera();
-    Vector3F viewDir = camera.target - camera.position;
-    work.getMesh().faces_ = performBackfaceCullingParallel(
-        work.getMesh().faces_, work.getMesh().vertices_, viewDir);
-
-    transformToCameraCoordinates(camera, work, work);  // world -> camera
-    projectToCamera(camera, work, work);               // camera -> clip space
-    clipedObject(camera, work);                        // отсечение граней
-
-    std::vector<Vertex> screenVertex(work.getMesh().vertices_.size());
-    projectToScreen(work, screenVertex);
-
-    if (m_settings.renderFace) {
-      rasterizeMesh(work.getMesh(), screenVertex, worldVertex, scene);
+    Face* culledFaces = arena_.allocate<Face>(mesh.faces_.size());
+    const size_t culledCount = performBackfaceCullingParallel(
+        mesh, object.getTransform(), camera.position, culledFaces);
+
+    // Дальше считаем только то, на что ссылаются уцелевшие грани.
+    const ReferencedIndices referenced =
+        collectReferencedIndices(culledFaces, culledCount, mesh, lighting);
+
+    // model -> view -> projection -> screen одним проходом по вершинам.
+    const Matrix4x4 mvp = camera.projection_matrix * camera.view_matrix *
+                          object.getTransform().matrix();
+    transformVertices(mvp, object, s, lighting, scene.getLight(0), referenced);
+    if (lighting) {
+      transformNormals(camera, object.getTransform(), mesh.normals_,
+                       referenced, s.normals);
+    }
+    if (lighting && m_settings.lighting == LightingModel::Gouraud) {
+      lightVertices(culledFaces, culledCount, referenced, s);
+    } else {
+      s.vertexNormals.clear();
+    }
+    // Отсечение: ближняя/дальняя плоскости и защитная полоса.
+    clipedObject(mesh, mvp, culledFaces, culledCount, lighting, s);
+
+    const size_t triangles = s.visibleFaces.size() + s.clippedTriangles.size();
+    firstTriangle[i + 1] = firstTriangle[i] + static_cast<uint32_t>(triangles);
+    if (faces) {
+      bins[i] = binTriangles(s, _framebuffer.width(), _framebuffer.height(),
+                             prepass);
     }
-    if (m_settings.renderDot || m_settings.renderLine) {
-      rasterizeMesh2(work.getMesh(), screenVertex, scene);
+    // С предпроходом объекты рисуются ниже, когда известна вся глубина.
+    if (prepass) continue;
+    if (faces) {
+      shaded += rasterizeMesh(
+          mesh, s, scene, bins[i], firstTriangle[i],
+          visibility ? SpanOp::Visibility : SpanOp::Shade);
     }
+    if (wire) rasterizeMesh2(s);
   }
 
+  if (prepass) {
+    // Глубина от порядка не зависит, поэтому предпроход идёт от ближних
+    // объектов к дальним: иерархическая глубина раньше закрывает дальние.
+    // Закраска — в исходном порядке: при равной глубине пиксель, как и без
+    // предпрохода, остаётся первому треугольнику, а каркас объекта
+    // перекрывают только следующие за ним объекты.
+    uint32_t* order = arena_.allocate<uint32_t>(objects.size());
+    std::iota(order, order + objects.size(), 0u);
+    std::stable_sort(order, order + objects.size(),
+                     [&](uint32_t a, uint32_t b) {
+                       return bins[a].nearest < bins[b].nearest;
+                     });
+    for (size_t k = 0; k < objects.size(); k++) {
+      const uint32_t i = order[k];
+      rasterizeMesh(objects[i].getMesh(), scratch_[i], scene, bins[i],
+                    firstTriangle[i], SpanOp::Depth);
+    }
+    for (size_t i = 0; i < objects.size(); i++) {
+      rasterizeMesh(objects[i].getMesh(), scratch_[i], scene, bins[i],
+                    firstTriangle[i], SpanOp::ShadeEqual);
+      if (wire) rasterizeMesh2(scratch_[i]);
+    }
+  }
+  if (visibility) shadeVisibleTriangles(scene, firstTriangle);
+  if (prepass) {
+    prepassFrames_++;
+  } else if (faces) {
+    updateOverdraw(shaded);
+  }
+  resolveFrame();
   QMutexLocker frontLocker(&_frontBufferMutex);
   swapBuffers();
 
+  frameAllocations_ += arena_.allocations() - arenaAllocations;
+  lastFrameAllocations_ = frameAllocations_;
+
   auto frameEnd = std::chrono::steady_clock::now();
   accountFrame(
-      std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+      std::chrono::duration<double, std::milli>(frameEnd - frameStart).count(),
+      frameAllocations_);
+}
+
+ShadingPipeline RenderRasterize::framePipeline() const {
+  if (m_settings.shadingPipeline != ShadingPipeline::Auto) {
+    return m_settings.shadingPipeline;
+  }
+  // С предпроходом каждый пиксель закрашивается один раз, и перекрытие не
+  // измерить: раз в kOverdrawProbeFrames кадров рисуем без него.
+  return prepassActive_ && prepassFrames_ < kOverdrawProbeFrames
+             ? ShadingPipeline::DepthPrepass
+             : ShadingPipeline::Forward;
 }
 
-void RenderRasterize::accountFrame(double frameMs) {
+void RenderRasterize::updateOverdraw(size_t shaded) {
+  const size_t covered = _framebuffer.coveredPixels();
+  lastOverdraw_ = covered ? static_cast<float>(shaded) / covered : 0.0f;
+  // Порог с запасом, чтобы режим не переключался на каждом замере.
+  prepassActive_ = lastOverdraw_ > (prepassActive_ ? kPrepassOverdrawOff
+                                                   : kPrepassOverdrawOn);
+  prepassFrames_ = 0;
+}
+
+void RenderRasterize::accountFrame(double frameMs, size_t allocations) {
   auto now = std::chrono::steady_clock::now();
   if (!fpsInited_) {
     fpsWindowStart_ = now;
@@ -62,6 +229,7 @@ void RenderRasterize::accountFrame(double frameMs) {
 
   fpsFrameCount_++;
   fpsMsAccum_ += frameMs;
+  fpsAllocAccum_ += allocations;
   fpsMsMin_ = std::min(fpsMsMin_, frameMs);
   fpsMsMax_ = std::max(fpsMsMax_, frameMs);
 
@@ -73,158 +241,255 @@ void RenderRasterize::accountFrame(double frameMs) {
     double realFps = fpsFrameCount_ * 1000.0 / windowMs;
     std::fprintf(stderr,
                  "[render] %.1f fps | frame avg %.2f ms (min %.2f, max %.2f) | "
-                 "потолок ~%.0f fps\n",
+                 "потолок ~%.0f fps | аллокаций за окно %zu\n",
                  realFps, avgMs, fpsMsMin_, fpsMsMax_,
-                 avgMs > 0.0 ? 1000.0 / avgMs : 0.0);
+                 avgMs > 0.0 ? 1000.0 / avgMs : 0.0, fpsAllocAccum_);
 
     fpsWindowStart_ = now;
     fpsFrameCount_ = 0;
     fpsMsAccum_ = 0.0;
+    fpsAllocAccum_ = 0;
     fpsMsMin_ = fpsMsMax_ = frameMs;
   }
 }
 
-void RenderRasterize::transformToWorldCoordinates(const Object& objInput,
-                                                  Object& objOutput) {
-  const Transform& transform = objInput.getTransform();
-  const std::vector<Vertex>& localVertexes = objInput.getMesh().vertices_;
-  const std::vector<Normal>& localNormals = objInput.getMesh().normals_;
-
-  std::vector<Vertex>& globalVertexes = objOutput.getMesh().vertices_;
-  std::vector<Normal>& globalNormals = objOutput.getMesh().normals_;
-
+RenderRasterize::ReferencedIndices RenderRasterize::collectReferencedIndices(
+    const Face* faces, size_t faceCount, const Mesh& mesh, bool normals) {
+  const size_t vertexCount = mesh.vertices_.size();
+  const size_t normalCount = normals ? mesh.normals_.size() : 0;
+  uint8_t* vertexMarks = arena_.allocate<uint8_t>(vertexCount);
+  uint8_t* normalMarks = arena_.allocate<uint8_t>(normalCount);
+  std::fill_n(vertexMarks, vertexCount, 0);
+  std::fill_n(normalMarks, normalCount, 0);
+
+  // Разные грани делят вершины, поэтому пишем отметки атомарно: на x86 это
+  // та же запись байта, но без гонки данных.
 #pragma omp parallel for
-  for (int i = 0; i < globalVertexes.size(); i++) {
-    globalVertexes[i] = transform.apply(localVertexes[i]);
+  for (long long i = 0; i < static_cast<long long>(faceCount); i++) {
+    for (int k = 0; k < 3; k++) {
+#pragma omp atomic write
+      vertexMarks[faces[i].vertexIndex[k]] = 1;
+      if (normals) {
+#pragma omp atomic write
+        normalMarks[faces[i].normalIndex[k]] = 1;
+      }
+    }
   }
 
-#pragma omp parallel for
-  for (int i = 0; i < globalNormals.size(); i++) {
-    globalNormals[i] = transform.applyToNormal(localNormals[i]);
-  }
+  ReferencedIndices referenced;
+  uint32_t* vertexIds = arena_.allocate<uint32_t>(vertexCount);
+  uint32_t* normalIds = arena_.allocate<uint32_t>(normalCount);
+  referenced.vertices = vertexIds;
+  referenced.vertexCount = compactMarked(vertexMarks, vertexCount, vertexIds);
+  referenced.normals = normalIds;
+  referenced.normalCount = compactMarked(normalMarks, normalCount, normalIds);
+  return referenced;
 }
 
-std::vector<Face> RenderRasterize::performBackfaceCullingParallel(
-    const std::vector<Face>& faces, const std::vector<Vertex>& vertices,
-    const Vector3F& viewDir) {
-  size_t num_faces = faces.size();
-  std::vector<Face> culledFaces;
-  culledFaces.reserve(num_faces);
-
-#pragma omp parallel
-  {
-    std::vector<Face> localFaces;
-    localFaces.reserve(num_faces / omp_get_num_threads());
-
-#pragma omp for nowait
-    for (size_t i = 0; i < num_faces; ++i) {
-      const auto& v0_4f = vertices[faces[i].vertexIndex[0]];
-      const auto& v1_4f = vertices[faces[i].vertexIndex[1]];
-      const auto& v2_4f = vertices[faces[i].vertexIndex[2]];
-
-      Vector3F v0(v0_4f.x() / v0_4f.w(), v0_4f.y() / v0_4f.w(),
-                  v0_4f.z() / v0_4f.w());
-      Vector3F v1(v1_4f.x() / v1_4f.w(), v1_4f.y() / v1_4f.w(),
-                  v1_4f.z() / v1_4f.w());
-      Vector3F v2(v2_4f.x() / v2_4f.w(), v2_4f.y() / v2_4f.w(),
-                  v2_4f.z() / v2_4f.w());
-
-      const auto faceNormal = (v1 - v0).cross(v2 - v0).normalized();
-
-      if (faceNormal.dot(viewDir) < -0.001) {
-        localFaces.push_back(faces[i]);
-      }
-    }
+size_t RenderRasterize::compactMarked(const uint8_t* marks, size_t count,
+                                      uint32_t* indices) {
+  return compactRanges(
+      arena_, count,
+      [&](size_t lo, size_t hi) {
+        size_t marked = 0;
+        for (size_t i = lo; i < hi; i++) marked += marks[i];
+        return marked;
+      },
+      [&](size_t lo, size_t hi, size_t out) {
+        for (size_t i = lo; i < hi; i++) {
+          if (marks[i]) indices[out++] = static_cast<uint32_t>(i);
+        }
+      });
+}
 
-#pragma omp critical
-    culledFaces.insert(culledFaces.end(), localFaces.begin(), localFaces.end());
+size_t RenderRasterize::performBackfaceCullingParallel(
+    const Mesh& mesh, const Transform& transform, const Vector3F& eyePosition,
+    Face* culledFaces) {
+  const MappedVector<Face>& faces = mesh.faces_;
+  const MappedVector<Plane>& planes = mesh.facePlanes_;
+  const size_t num_faces = faces.size();
+
+  if (planes.size() != num_faces) {  // плоскости не посчитаны — не отсекаем
+    std::copy(faces.begin(), faces.end(), culledFaces);
+    return num_faces;
   }
 
-  return culledFaces;
+  // Глаз переводим в пространство объекта один раз на кадр: грань видна, если
+  // он лежит перед её плоскостью. Зеркальная трансформация (det < 0) меняет
+  // обход граней, а с ним и сторону плоскости.
+  const Matrix4x4& model = transform.matrix();
+  const Vertex eye =
+      model.inverse() * Vertex(eyePosition.x(), eyePosition.y(),
+                               eyePosition.z(), 1.0f);
+  const float handedness =
+      model.block<3, 3>(0, 0).determinant() < 0.0f ? -1.0f : 1.0f;
+
+  return compactIf(arena_, faces.data(), num_faces, culledFaces,
+                   [&](size_t i) {
+                     return handedness * planes[i].dot(eye) > 0.0f;
+                   });
 }
 
-void RenderRasterize::transformToCameraCoordinates(const Camera& camera,
-                                                   const Object& objInput,
-                                                   Object& objOutput) {
-  const std::vector<Vertex>& localVertexes = objInput.getMesh().vertices_;
-  const std::vector<Normal>& localNormals = objInput.getMesh().normals_;
+void RenderRasterize::transformVertices(const Matrix4x4& mvp,
+                                        const Object& object,
+                                        ObjectScratch& scratch, bool lighting,
+                                        const Light& light,
+                                        const ReferencedIndices& referenced) {
+  const Transform& transform = object.getTransform();
+  const MappedVector<Vertex>& localVertexes = object.getMesh().vertices_;
+  const size_t count = localVertexes.size();
+
+  // Буферы в размер меша, чтобы индексы граней не менялись; пишутся только
+  // вершины видимых граней. Мировые вершины нужны только освещению, а без
+  // попиксельного на их месте — направления на свет.
+  if (lighting) resizeScratch(scratch.worldVertices, count);
+  const bool lightDirections = m_settings.lighting != LightingModel::Phong;
+  resizeScratch(scratch.screenVertices, count);
+  resizeScratch(scratch.outcodes, count);
+
+  const Matrix4x4 model = transform.matrix();
+  const float halfW = 0.5f * _backBuffer.width();
+  const float halfH = 0.5f * _backBuffer.height();
+  Vertex* world = scratch.worldVertices.data();
+  Vertex* screen = scratch.screenVertices.data();
+  uint8_t* outcodes = scratch.outcodes.data();
+  const uint32_t* ids = referenced.vertices;
+  const int idCount = static_cast<int>(referenced.vertexCount);
 
-  std::vector<Vertex>& globalVertexes = objOutput.getMesh().vertices_;
-  std::vector<Normal>& globalNormals = objOutput.getMesh().normals_;
+#pragma omp parallel for
+  for (int k = 0; k < idCount; k++) {
+    const uint32_t i = ids[k];
+    const Vertex& local = localVertexes[i];
+    if (lighting) {
+      world[i] = model * local;
+      if (lightDirections) {
+        Normal l = light.position - world[i].head<3>();
+        const float length = l.norm();
+        if (length > 0.0f) l /= length;
+        world[i] << l, 0.0f;
+      }
+    }
 
-  Matrix4x4 matrixVertex = camera.view_matrix;
-  Eigen::Matrix3f matrixNormal =
-      matrixVertex.block<3, 3>(0, 0).inverse().transpose();
+    const Vertex clip = mvp * local;
+    const float w = clip.w();
+    uint8_t code = w > 0.0f ? 0 : kOutBehind;
+    if (clip.x() < -w) code |= kOutLeft;
+    if (clip.x() > w) code |= kOutRight;
+    if (clip.y() < -w) code |= kOutBottom;
+    if (clip.y() > w) code |= kOutTop;
+    if (clip.z() < -w) code |= kOutNear;
+    if (clip.z() > w) code |= kOutFar;
+    if (std::abs(clip.x()) > kGuardBand * w ||
+        std::abs(clip.y()) > kGuardBand * w) {
+      code |= kOutGuard;
+    }
+    outcodes[i] = code;
 
-#pragma omp parallel for
-  for (int i = 0; i < globalVertexes.size(); i++) {
-    globalVertexes[i] = matrixVertex * localVertexes[i];
+    // Экранные координаты вершин с kOutNeedsClip не читаются: их грани
+    // идут через отсечение.
+    screen[i] = toScreen(clip, halfW, halfH);
   }
+}
+
+void RenderRasterize::transformNormals(const Camera& camera,
+                                       const Transform& transform,
+                                       const MappedVector<Normal>& localNormals,
+                                       const ReferencedIndices& referenced,
+                                       std::vector<Normal>& globalNormals) {
+  resizeScratch(globalNormals, localNormals.size());
+
+  // Матрица нормалей вида на матрицу нормалей модели: нормали камеры из
+  // исходных за одно чтение.
+  const Eigen::Matrix3f viewNormal =
+      camera.view_matrix.block<3, 3>(0, 0).inverse().transpose();
+  const Eigen::Matrix3f matrixNormal = viewNormal * transform.normalMatrix();
+
+  const uint32_t* ids = referenced.normals;
+  const int idCount = static_cast<int>(referenced.normalCount);
 
 #pragma omp parallel for
-  for (int i = 0; i < globalNormals.size(); i++) {
+  for (int k = 0; k < idCount; k++) {
+    const uint32_t i = ids[k];
     globalNormals[i] = (matrixNormal * localNormals[i]).normalized();
   }
 }
 
-void RenderRasterize::projectToCamera(const Camera& camera,
-                                      const Object& objInput,
-                                      Object& objOutput) {
-  const std::vector<Vertex>& localVertexes = objInput.getMesh().vertices_;
-  std::vector<Vertex>& globalVertexes = objOutput.getMesh().vertices_;
-  Matrix4x4 matrixVertex = camera.projection_matrix;
+float RenderRasterize::vertexCosine(const Normal& n, const Vertex& toLight) {
+  return std::max(n.dot(toLight.head<3>()), 0.0f);
+}
+
+void RenderRasterize::lightVertices(const Face* faces, size_t faceCount,
+                                    const ReferencedIndices& referenced,
+                                    ObjectScratch& scratch) {
+  resizeScratch(scratch.vertexNormals, scratch.worldVertices.size());
+  uint32_t* vertexNormals = scratch.vertexNormals.data();
+  const int count = static_cast<int>(faceCount);
+
+  // Вершине достаётся нормаль любого из её углов: какой именно — не важно,
+  // остальные углы настройка треугольника досчитает сама.
+#pragma omp parallel for schedule(static)
+  for (int f = 0; f < count; f++) {
+    for (int k = 0; k < 3; k++) {
+#pragma omp atomic write
+      vertexNormals[faces[f].vertexIndex[k]] = faces[f].normalIndex[k];
+    }
+  }
 
-#pragma omp parallel for
-  for (int i = 0; i < globalVertexes.size(); i++) {
-    globalVertexes[i] = matrixVertex * localVertexes[i];
+  Vertex* world = scratch.worldVertices.data();
+  const Normal* normals = scratch.normals.data();
+  const uint32_t* ids = referenced.vertices;
+  const int idCount = static_cast<int>(referenced.vertexCount);
+#pragma omp parallel for schedule(static)
+  for (int k = 0; k < idCount; k++) {
+    const uint32_t i = ids[k];
+    world[i].w() = vertexCosine(normals[vertexNormals[i]], world[i]);
   }
 }
 
-void RenderRasterize::projectToScreen(const Object& objInput,
-                                      std::vector<Vertex>& screenVertex) {
-  const std::vector<Vertex>& cameraVertexes = objInput.getMesh().vertices_;
-  for (int i = 0; i < cameraVertexes.size(); i++) {
-    float w = cameraVertexes[i].w();
-    screenVertex[i].x() =
-        (cameraVertexes[i].x() / w + 1) * 0.5f * _backBuffer.width();
-    screenVertex[i].y() =
-        (1.0f - cameraVertexes[i].y() / w) * 0.5f * _backBuffer.height();
-    screenVertex[i].z() = cameraVertexes[i].z() / w;
-    screenVertex[i].w() = w;
+void RenderRasterize::rasterizeMesh2(const ObjectScratch& scratch) {
+  const std::vector<Face>& faces = scratch.visibleFaces;
+  const std::vector<Vertex>& screenVertex = scratch.screenVertices;
+  const std::vector<ClippedTriangle>& clipped = scratch.clippedTriangles;
+  const int faceCount = static_cast<int>(faces.size());
+  const int total = faceCount + static_cast<int>(clipped.size());
+
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < total; i++) {
+    if (i < faceCount) {
+      const Face& face = faces[i];
+      drawWireTriangle(screenVertex[face.vertexIndex[0]],
+                       screenVertex[face.vertexIndex[1]],
+                       screenVertex[face.vertexIndex[2]]);
+    } else {
+      const ClippedTriangle& t = clipped[i - faceCount];
+      drawWireTriangle(t.screen[0], t.screen[1], t.screen[2]);
+    }
   }
 }
 
-void RenderRasterize::rasterizeMesh2(const Mesh& mesh,
-                                     std::vector<Vertex>& screenVertex,
-                                     const Scene& scene) {
-#pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < static_cast<int>(mesh.faces_.size()); i++) {
-    const Face& face = mesh.faces_[i];
-    const Vertex& v0 = screenVertex[face.vertexIndex[0]];
-    const Vertex& v1 = screenVertex[face.vertexIndex[1]];
-    const Vertex& v2 = screenVertex[face.vertexIndex[2]];
-
-    if (m_settings.renderLine) {
-      drawLine(v0, v1);
-      drawLine(v1, v2);
-      drawLine(v2, v0);
-    };
-    if (m_settings.renderDot) {
-      if (m_settings.cirul) {
-        drawPointAsCircle(v0);
-        drawPointAsCircle(v1);
-        drawPointAsCircle(v2);
-      } else {
-        drawPointAsSquar(v0);
-        drawPointAsSquar(v1);
-        drawPointAsSquar(v2);
-      }
+void RenderRasterize::drawWireTriangle(const Vertex& v0, const Vertex& v1,
+                                       const Vertex& v2) {
+  if (m_settings.renderLine) {
+    drawLine(v0, v1);
+    drawLine(v1, v2);
+    drawLine(v2, v0);
+  };
+  if (m_settings.renderDot) {
+    if (m_settings.cirul) {
+      drawPointAsCircle(v0);
+      drawPointAsCircle(v1);
+      drawPointAsCircle(v2);
+    } else {
+      drawPointAsSquar(v0);
+      drawPointAsSquar(v1);
+      drawPointAsSquar(v2);
     }
   }
 }
 
 void RenderRasterize::drawLine(const Vertex& p1, const Vertex& p2) {
-  Color color = m_settings.lineColor;
+  const Color& color = m_settings.lineColor;
+  const uint32_t argb = QColor(color.x(), color.y(), color.z()).rgb();
   int x1 = p1.x(), y1 = p1.y();
   int x2 = p2.x(), y2 = p2.y();
 
@@ -237,10 +502,9 @@ void RenderRasterize::drawLine(const Vertex& p1, const Vertex& p2) {
   bool drawPixel = true;
 
   while (true) {
-    if (drawPixel) {
-      _backBuffer.setPixelColor(x1, y1,
-                                QColor(color.x(), color.y(), color.z()));
-    }
+    // Концы рёбер могут лежать в защитной полосе за краем экрана — такие
+    // пиксели setPixel пропускает.
+    if (drawPixel) _framebuffer.setPixel(x1, y1, argb);
 
     if (x1 == x2 && y1 == y2) break;
 
@@ -265,7 +529,8 @@ void RenderRasterize::drawLine(const Vertex& p1, const Vertex& p2) {
 }
 void RenderRasterize::drawPointAsCircle(const Vertex& center) {
   int radius = m_settings.vertexSize;
-  Color color = m_settings.vertexColor;
+  const Color& color = m_settings.vertexColor;
+  const uint32_t argb = QColor(color.x(), color.y(), color.z()).rgb();
 
   if (radius <= 0) {
     return;
@@ -276,8 +541,7 @@ void RenderRasterize::drawPointAsCircle(const Vertex& center) {
       if (x * x + y * y <= radius * radius) {
         int pixelX = center.x() + x;
         int pixelY = center.y() + y;
-        _backBuffer.setPixelColor(pixelX, pixelY,
-                                  QColor(color.x(), color.y(), color.z()));
+        _framebuffer.setPixel(pixelX, pixelY, argb);
       }
     }
   }
@@ -285,7 +549,8 @@ void RenderRasterize::drawPointAsCircle(const Vertex& center) {
 
 void RenderRasterize::drawPointAsSquar(const Vertex& center) {
   int radius = m_settings.vertexSize;
-  Color color = m_settings.vertexColor;
+  const Color& color = m_settings.vertexColor;
+  const uint32_t argb = QColor(color.x(), color.y(), color.z()).rgb();
 
   if (radius <= 0) {
     return;
@@ -295,223 +560,599 @@ void RenderRasterize::drawPointAsSquar(const Vertex& center) {
     for (int x = -radius; x <= radius; ++x) {
       int pixelX = center.x() + x;
       int pixelY = center.y() + y;
-      _backBuffer.setPixelColor(pixelX, pixelY,
-                                QColor(color.x(), color.y(), color.z()));
+      _framebuffer.setPixel(pixelX, pixelY, argb);
     }
   }
 }
 
-void RenderRasterize::rasterizeMesh(const Mesh& mesh,
-                                    std::vector<Vertex>& screenVertex,
-                                    const std::vector<Vertex>& globalVertex,
-                                    const Scene& scene) {
-  const int W = _backBuffer.width();
-  const int H = _backBuffer.height();
-  // Один detach в начале — дальше потоки пишут в сырые байты напрямую.
-  unsigned char* bits = _backBuffer.bits();
-  const qsizetype bpl = _backBuffer.bytesPerLine();
+size_t RenderRasterize::rasterizeMesh(const Mesh& mesh,
+                                      const ObjectScratch& scratch,
+                                      const Scene& scene, const TileBins& bins,
+                                      uint32_t firstTriangle, SpanOp pass) {
+  const int W = _framebuffer.width();
+  const int H = _framebuffer.height();
   const Light& light = scene.getLight(0);
-
-  // Делим экран на горизонтальные полосы строк и раздаём потокам. Полоса владеет
-  // своими строками, так что записи в цвет/глубину не пересекаются и блокировки
-  // не нужны. Полос берём больше, чем потоков: треугольники по кадру распределены
+  // Предпроходу порядок не важен: в плитке он идёт по группам от ближних к
+  // дальним (ключ — глубина группы и номер треугольника).
+  uint64_t* depthOrder =
+      pass == SpanOp::Depth
+          ? arena_.allocate<uint64_t>(bins.offsets[bins.tilesX * bins.tilesY])
+          : nullptr;
+  const SpanKernels kernels =
+      bestSpanKernels(pass, _framebuffer.depthFormat(), m_settings.lighting,
+                      m_settings.textureFilter);
+
+  // Плитка владеет своими пикселями, так что записи в цвет/глубину не
+  // пересекаются и блокировки не нужны. Треугольники по экрану распределены
   // неравномерно, и schedule(dynamic) сам выравнивает нагрузку.
-  const int bands = std::min(H, std::max(1, omp_get_max_threads() * 4));
+  size_t written = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : written)
+  for (int tile = 0; tile < bins.tilesX * bins.tilesY; ++tile) {
+    const int xLo = tile % bins.tilesX * kTileSize;
+    const int yLo = tile / bins.tilesX * kTileSize;
+    const int xHi = std::min(W, xLo + kTileSize);
+    const int yHi = std::min(H, yLo + kTileSize);
+    // Плитку без треугольников не трогаем: её фон допишет resolve().
+    if (bins.offsets[tile] == bins.offsets[tile + 1]) continue;
+    _framebuffer.prepareTile(tile);
+    if (depthOrder) {
+      for (uint32_t k = bins.offsets[tile]; k < bins.offsets[tile + 1]; ++k) {
+        const uint32_t id = bins.triangles[k];
+        const float nearest = bins.clusterNearest[id / kClusterSize];
+        depthOrder[k] = uint64_t{orderedBits(nearest)} << 32 | id;
+      }
+      std::sort(depthOrder + bins.offsets[tile],
+                depthOrder + bins.offsets[tile + 1]);
+    }
 
-#pragma omp parallel for schedule(dynamic)
-  for (int b = 0; b < bands; ++b) {
-    const int yLo = static_cast<int>(static_cast<long long>(b) * H / bands);
-    const int yHi = static_cast<int>(static_cast<long long>(b + 1) * H / bands);
-
-    for (size_t i = 0; i < mesh.faces_.size(); ++i) {
-      const Face& face = mesh.faces_[i];
-      const Vertex& v0 = screenVertex[face.vertexIndex[0]];
-      const Vertex& v1 = screenVertex[face.vertexIndex[1]];
-      const Vertex& v2 = screenVertex[face.vertexIndex[2]];
-
-      // Быстрый отбор: треугольник не задевает строки этой полосы.
-      int triMinY = static_cast<int>(std::min({v0.y(), v1.y(), v2.y()}));
-      int triMaxY = static_cast<int>(std::max({v0.y(), v1.y(), v2.y()}));
-      if (triMaxY < yLo || triMinY >= yHi) continue;
-
-      drawTriangle(v0, v1, v2, mesh.uvCoordinates_[face.uvCoordinateIndex[0]],
-                   mesh.uvCoordinates_[face.uvCoordinateIndex[1]],
-                   mesh.uvCoordinates_[face.uvCoordinateIndex[2]],
-                   mesh.normals_[face.normalIndex[0]],
-                   mesh.normals_[face.normalIndex[1]],
-                   mesh.normals_[face.normalIndex[2]],
-                   globalVertex[face.vertexIndex[0]],
-                   globalVertex[face.vertexIndex[1]],
-                   globalVertex[face.vertexIndex[2]], light,
-                   scene.getMaterial(face.materialIndex), yLo, yHi, bits, bpl, W,
-                   H);
+    for (uint32_t k = bins.offsets[tile]; k < bins.offsets[tile + 1]; ++k) {
+      const uint32_t id = depthOrder ? static_cast<uint32_t>(depthOrder[k])
+                                     : bins.triangles[k];
+      const TriangleRef t = triangleAt(mesh, scratch, id);
+      const Material& material = scene.getMaterial(t.materialIndex);
+      written += drawTriangle(
+          t, firstTriangle + id, light, material, xLo, xHi, yLo, yHi, tile,
+          pass, textured(material) ? kernels.textured : kernels.plain);
     }
   }
+  return written;
 }
 
-void RenderRasterize::drawTriangle(
-    const Vertex& v0, const Vertex& v1, const Vertex& v2,
-    const UVCoordinate texture_coord_0, const UVCoordinate texture_coord_1,
-    const UVCoordinate texture_coord_2, const Normal normal0,
-    const Normal normal1, const Normal normal3, const Vertex& vg1,
-    const Vertex& vg2, const Vertex& vg3, const Light& light,
-    const Material& material, int yLo, int yHi, unsigned char* bits,
-    qsizetype bpl, int W, int H) {
-  Eigen::Vector2i p0(v0.x(), v0.y());
-  Eigen::Vector2i p1(v1.x(), v1.y());
-  Eigen::Vector2i p2(v2.x(), v2.y());
-
-  int minX = std::max(0, std::min({p0.x(), p1.x(), p2.x()}));
-  int maxX = std::min(W - 1, std::max({p0.x(), p1.x(), p2.x()}));
-  // Y зажимаем и буфером, и границами текущей полосы [yLo, yHi).
-  int minY = std::max(yLo, std::min({p0.y(), p1.y(), p2.y()}));
-  int maxY = std::min(yHi - 1, std::max({p0.y(), p1.y(), p2.y()}));
-  if (minX > maxX || minY > maxY) return;
-
-  float area = triangleArea(p0, p1, p2);
-  if (area <= 0.0f) return;  // вырожденный треугольник
-
-  const bool useTexture =
-      m_settings.texture && !material.texture.colors_.empty();
-
-  for (int x = minX; x <= maxX; ++x) {
-    std::vector<float>& depthCol = depthBuffer[x];  // непрерывно по y
-    for (int y = minY; y <= maxY; ++y) {
-      Eigen::Vector2i p(x, y);
-      Eigen::Vector3f baryCoords = barycentricCoords(p, p0, p1, p2, area);
-      if (baryCoords[0] < 0 || baryCoords[1] < 0 || baryCoords[2] < 0 ||
-          std::abs(baryCoords.sum() - 1.0f) >= 1e-6f)
-        continue;
+void RenderRasterize::shadeVisibleTriangles(Scene& scene,
+                                            const uint32_t* firstTriangle) {
+  const auto& objects = scene.getObjects();
+  const Light& light = scene.getLight(0);
+  const int W = _framebuffer.width();
+  const int H = _framebuffer.height();
+  const int tilesX = _framebuffer.tilesX();
+
+  // Закраска плитки — по отрезкам строки с одним треугольником. Плоскости
+  // треугольника считаются по его номеру и кешируются: соседние отрезки
+  // обычно принадлежат тем же треугольникам.
+  struct CachedSetup {
+    uint32_t triangle = Framebuffer::kNoTriangle;
+    SpanSetup setup;
+  };
+  constexpr uint32_t kCacheSize = 16;
+  const ShadePixelsFn shadePlain =
+      bestShadePixels(m_settings.lighting, m_settings.textureFilter, false);
+  const ShadePixelsFn shadeTextured =
+      bestShadePixels(m_settings.lighting, m_settings.textureFilter, true);
 
-      float depth = interpolate(v0.z(), v1.z(), v2.z(), baryCoords);
-      if (depth >= depthCol[y]) continue;
-      depthCol[y] = depth;
-
-      Normal interpolateNormal =
-          interpolate(normal0, normal1, normal3, baryCoords);
-      Vertex interpolateGlobalVertex = interpolate(vg1, vg2, vg3, baryCoords);
-      Color lightColor = calculatePhongIlluminationForVertex(
-          interpolateGlobalVertex, interpolateNormal, material, light,
-          Vector3F{0.0f, 0.0f, 150.0f});
-
-      Color finalColor = lightColor;
-      if (useTexture) {
-        UVCoordinate w0 = texture_coord_0 / v0.w();
-        UVCoordinate w1 = texture_coord_1 / v1.w();
-        UVCoordinate w2 = texture_coord_2 / v2.w();
-        UVCoordinate uv = interpolate(w0, w1, w2, baryCoords);
-        uv *= (1.0f / interpolate(1.0f / v0.w(), 1.0f / v1.w(), 1.0f / v2.w(),
-                                  baryCoords));
-        int x1 = std::clamp(
-            static_cast<int>(uv.x() * (material.texture.width_ - 1)), 0,
-            material.texture.width_ - 1);
-        int y1 = std::clamp(
-            static_cast<int>(uv.y() * (material.texture.height_ - 1)), 0,
-            material.texture.height_ - 1);
-        const Color& texture_color =
-            material.texture.colors_[y1 * material.texture.width_ + x1];
-        finalColor = (lightColor / 255).cwiseProduct(texture_color / 255) * 255;
+#pragma omp parallel for schedule(dynamic)
+  for (int tile = 0; tile < tilesX * _framebuffer.tilesY(); ++tile) {
+    if (_framebuffer.isCleared(tile)) continue;
+    const int width = std::min(kTileSize, W - tile % tilesX * kTileSize);
+    const int height = std::min(kTileSize, H - tile / tilesX * kTileSize);
+    const uint32_t* triangles = _framebuffer.triangleTile(tile);
+    const float* weights1 = _framebuffer.weightTile(tile, 0);
+    const float* weights2 = _framebuffer.weightTile(tile, 1);
+    uint32_t* color = _framebuffer.colorTile(tile);
+    CachedSetup cache[kCacheSize];
+
+    for (int y = 0; y < height; ++y) {
+      const int row = y * kTileSize;
+      for (int x = 0; x < width;) {
+        const uint32_t triangle = triangles[row + x];
+        int end = x + 1;
+        while (end < width && triangles[row + end] == triangle) ++end;
+        if (triangle != Framebuffer::kNoTriangle) {
+          CachedSetup& cached = cache[triangle % kCacheSize];
+          if (cached.triangle != triangle) {
+            // Объект треугольника — последний с firstTriangle <= triangle.
+            const size_t object =
+                std::upper_bound(firstTriangle,
+                                 firstTriangle + objects.size(), triangle) -
+                firstTriangle - 1;
+            TriangleRef t =
+                triangleAt(objects[object].getMesh(), scratch_[object],
+                           triangle - firstTriangle[object]);
+            int64_t fx[3], fy[3];
+            orientTriangle(t, fx, fy);
+            cached.triangle = triangle;
+            cached.setup = SpanSetup();
+            setupShading(t, light, scene.getMaterial(t.materialIndex),
+                         cached.setup);
+          }
+          (cached.setup.texture ? shadeTextured : shadePlain)(
+              cached.setup, weights1 + row + x, weights2 + row + x,
+              color + row + x, end - x);
+        }
+        x = end;
       }
-
-      quint32* px = reinterpret_cast<quint32*>(bits + static_cast<qsizetype>(y) *
-                                                          bpl);
-      px[x] = 0xFF000000u |
-              (static_cast<quint32>(std::clamp(int(finalColor[0]), 0, 255))
-               << 16) |
-              (static_cast<quint32>(std::clamp(int(finalColor[1]), 0, 255))
-               << 8) |
-              static_cast<quint32>(std::clamp(int(finalColor[2]), 0, 255));
     }
   }
 }
 
-Eigen::Vector3f RenderRasterize::calculatePhongIlluminationForVertex(
-    const Vertex& v, const Normal& n, const Material& material,
-    const Light& light, const Eigen::Vector3f& viewPos) {
-  Eigen::Vector3f vertexPos = v.head<3>();
-  Eigen::Vector3f lightDir = (light.position - vertexPos).normalized();
-
-  Eigen::Vector3f ambient = calculateAmbient(material, light);
-  Eigen::Vector3f diffuse = calculateDiffuse(material, light, n, lightDir);
-  Eigen::Vector3f specular = Eigen::Vector3f::Zero();
-
-  Eigen::Vector3f color = ambient + diffuse + specular;
-  color = color.cwiseMin(255.0f).cwiseMax(0.0f);
-
-  return color;
-}
+RenderRasterize::TileBins RenderRasterize::binTriangles(
+    const ObjectScratch& scratch, int W, int H, bool clusterDepth) {
+  const std::vector<Face>& faces = scratch.visibleFaces;
+  const std::vector<Vertex>& screenVertex = scratch.screenVertices;
+  const size_t faceCount = faces.size();
+  const size_t total = faceCount + scratch.clippedTriangles.size();
+
+  TileBins bins;
+  bins.tilesX = (W + kTileSize - 1) / kTileSize;
+  bins.tilesY = (H + kTileSize - 1) / kTileSize;
+  const size_t tileCount = static_cast<size_t>(bins.tilesX) * bins.tilesY;
+
+  // Треугольники режутся на куски по потокам; у каждого куска свои счётчики
+  // по плиткам. Префиксная сумма по плиткам, а внутри плитки — по кускам,
+  // даёт каждому куску место записи, так что в плитке треугольники идут в
+  // исходном порядке при любом числе потоков.
+  const int chunks = std::max(1, omp_get_max_threads());
+  uint32_t* cursor = arena_.allocate<uint32_t>(chunks * tileCount);
+  float* chunkNearest = arena_.allocate<float>(chunks);
+  TileRange* ranges = arena_.allocate<TileRange>(total);
+  uint32_t* offsets = arena_.allocate<uint32_t>(tileCount + 1);
+
+  auto chunkBegin = [&](int k) { return total * k / chunks; };
+
+#pragma omp parallel for schedule(static)
+  for (int k = 0; k < chunks; ++k) {
+    uint32_t* counts = cursor + k * tileCount;
+    std::fill(counts, counts + tileCount, 0u);
+    float nearest = 1.0f;
+    for (size_t i = chunkBegin(k); i < chunkBegin(k + 1); ++i) {
+      const Vertex* v[3];
+      if (i < faceCount) {
+        for (int c = 0; c < 3; c++) {
+          v[c] = &screenVertex[faces[i].vertexIndex[c]];
+        }
+      } else {
+        for (int c = 0; c < 3; c++) {
+          v[c] = &scratch.clippedTriangles[i - faceCount].screen[c];
+        }
+      }
+      // Те же пиксели, что возьмёт drawTriangle: округление до субпикселя.
+      int64_t fx[3], fy[3];
+      for (int c = 0; c < 3; c++) {
+        fx[c] = toFixed(v[c]->x());
+        fy[c] = toFixed(v[c]->y());
+      }
+      const PixelBounds px = pixelBounds(fx, fy, W, H);
+      TileRange& r = ranges[i];
+      if (px.empty()) {
+        r = {1, 1, 0, 0};  // за экраном
+        continue;
+      }
+      r = {static_cast<uint16_t>(px.minX / kTileSize),
+           static_cast<uint16_t>(px.minY / kTileSize),
+           static_cast<uint16_t>(px.maxX / kTileSize),
+           static_cast<uint16_t>(px.maxY / kTileSize)};
+      nearest = std::min({nearest, v[0]->z(), v[1]->z(), v[2]->z()});
+      for (int ty = r.y0; ty <= r.y1; ++ty) {
+        for (int tx = r.x0; tx <= r.x1; ++tx) counts[ty * bins.tilesX + tx]++;
+      }
+    }
+    chunkNearest[k] = nearest;
+  }
+  bins.nearest = *std::min_element(chunkNearest, chunkNearest + chunks);
+
+  // Ближайшая глубина каждой группы треугольников — для порядка предпрохода.
+  const size_t clusters =
+      clusterDepth ? (total + kClusterSize - 1) / kClusterSize : 0;
+  float* clusterNearest =
+      clusterDepth ? arena_.allocate<float>(clusters) : nullptr;
+#pragma omp parallel for schedule(static)
+  for (size_t c = 0; c < clusters; ++c) {
+    float nearest = 1.0f;
+    const size_t end = std::min(total, (c + 1) * kClusterSize);
+    for (size_t i = c * kClusterSize; i < end; ++i) {
+      const Vertex* v[3];
+      if (i < faceCount) {
+        for (int k = 0; k < 3; k++) {
+          v[k] = &screenVertex[faces[i].vertexIndex[k]];
+        }
+      } else {
+        for (int k = 0; k < 3; k++) {
+          v[k] = &scratch.clippedTriangles[i - faceCount].screen[k];
+        }
+      }
+      nearest = std::min({nearest, v[0]->z(), v[1]->z(), v[2]->z()});
+    }
+    clusterNearest[c] = nearest;
+  }
+  bins.clusterNearest = clusterNearest;
+
+  uint32_t running = 0;
+  for (size_t tile = 0; tile < tileCount; ++tile) {
+    offsets[tile] = running;
+    for (int k = 0; k < chunks; ++k) {
+      const uint32_t count = cursor[k * tileCount + tile];
+      cursor[k * tileCount + tile] = running;
+      running += count;
+    }
+  }
+  offsets[tileCount] = running;
+  uint32_t* triangles = arena_.allocate<uint32_t>(running);
+
+#pragma omp parallel for schedule(static)
+  for (int k = 0; k < chunks; ++k) {
+    uint32_t* next = cursor + k * tileCount;
+    for (size_t i = chunkBegin(k); i < chunkBegin(k + 1); ++i) {
+      const TileRange& r = ranges[i];
+      for (int ty = r.y0; ty <= r.y1; ++ty) {
+        for (int tx = r.x0; tx <= r.x1; ++tx) {
+          triangles[next[ty * bins.tilesX + tx]++] = static_cast<uint32_t>(i);
+        }
+      }
+    }
+  }
 
-Eigen::Vector3f RenderRasterize::calculateAmbient(const Material& material,
-                                                  const Light& light) {
-  return material.ambient.cwiseProduct(light.color);
+  bins.offsets = offsets;
+  bins.triangles = triangles;
+  return bins;
 }
 
-Eigen::Vector3f RenderRasterize::calculateDiffuse(
-    const Material& material, const Light& light, const Normal& normal,
-    const Eigen::Vector3f& lightDir) {
-  float diff = std::max(normal.dot(lightDir), 0.0f);
-  return material.diffuse.cwiseProduct(light.color) * diff;
+RenderRasterize::TriangleRef RenderRasterize::triangleAt(
+    const Mesh& mesh, const ObjectScratch& scratch, uint32_t id) {
+  TriangleRef t;
+  const uint32_t faceCount = static_cast<uint32_t>(scratch.visibleFaces.size());
+  if (id < faceCount) {
+    const Face& face = scratch.visibleFaces[id];
+    const bool cached = !scratch.vertexNormals.empty();
+    for (int k = 0; k < 3; k++) {
+      const uint32_t vertex = face.vertexIndex[k];
+      t.screen[k] = &scratch.screenVertices[vertex];
+      t.uv[k] = &mesh.uvCoordinates_[face.uvCoordinateIndex[k]];
+      t.normal[k] = &scratch.normals[face.normalIndex[k]];
+      t.world[k] = &scratch.worldVertices[vertex];
+      if (cached && scratch.vertexNormals[vertex] == face.normalIndex[k]) {
+        t.cosine[k] = &scratch.worldVertices[vertex].w();
+      }
+    }
+    t.materialIndex = face.materialIndex;
+  } else {
+    // Треугольники, порезанные при отсечении, несут атрибуты с собой.
+    const ClippedTriangle& clipped = scratch.clippedTriangles[id - faceCount];
+    for (int k = 0; k < 3; k++) {
+      t.screen[k] = &clipped.screen[k];
+      t.uv[k] = &clipped.uv[k];
+      t.normal[k] = &clipped.normal[k];
+      t.world[k] = &clipped.world[k];
+    }
+    t.materialIndex = clipped.materialIndex;
+  }
+  return t;
 }
 
-void RenderRasterize::clipedObject(const Camera& camera, Object& cameraObj) {
-  const Mesh& mesh = cameraObj.getMesh();
-  float xmin = -1.0f, xmax = 1.0f;
-  float ymin = -1.0f, ymax = 1.0f;
-  float zmin = -1.0f, zmax = 1.0f;
-
-  std::vector<Face> faces;
-
-#pragma omp parallel
-  {
-    std::vector<Face> localFaces;
-
-#pragma omp for nowait
-    for (int i = 0; i < mesh.faces_.size(); i++) {
-      const Face& face = mesh.faces_[i];
-      Vertex v0 = mesh.vertices_[face.vertexIndex[0]];
-      Vertex v1 = mesh.vertices_[face.vertexIndex[1]];
-      Vertex v2 = mesh.vertices_[face.vertexIndex[2]];
-      v0 /= v0.w();
-      v1 /= v1.w();
-      v2 /= v2.w();
-
-      if (v0.x() < xmin || v0.x() > xmax || v0.y() < ymin || v0.y() > ymax ||
-          v0.z() < zmin || v0.z() > zmax ||
+int64_t RenderRasterize::orientTriangle(TriangleRef& t, int64_t fx[3],
+                                        int64_t fy[3]) {
+  for (int k = 0; k < 3; k++) {
+    fx[k] = toFixed(t.screen[k]->x());
+    fy[k] = toFixed(t.screen[k]->y());
+  }
 
-          v1.x() < xmin || v1.x() > xmax || v1.y() < ymin || v1.y() > ymax ||
-          v1.z() < zmin || v1.z() > zmax ||
+  // Удвоенная площадь в единицах субпикселя. Рисуются обе ориентации:
+  // отрицательную приводим к положительной перестановкой вершин 1 и 2.
+  int64_t area = (fx[1] - fx[0]) * (fy[2] - fy[0]) -
+                 (fy[1] - fy[0]) * (fx[2] - fx[0]);
+  if (area < 0) {
+    std::swap(fx[1], fx[2]);
+    std::swap(fy[1], fy[2]);
+    std::swap(t.screen[1], t.screen[2]);
+    std::swap(t.uv[1], t.uv[2]);
+    std::swap(t.normal[1], t.normal[2]);
+    std::swap(t.world[1], t.world[2]);
+    std::swap(t.cosine[1], t.cosine[2]);
+    area = -area;
+  }
+  return area;
+}
 
-          v2.x() < xmin || v2.x() > xmax || v2.y() < ymin || v2.y() > ymax ||
-          v2.z() < zmin || v2.z() > zmax) {
-        continue;
+void RenderRasterize::setupShading(const TriangleRef& t, const Light& light,
+                                   const Material& material,
+                                   SpanSetup& setup) const {
+  // Атрибуты задаются вершиной 0 и приращениями к вершинам 1 и 2; в пикселе
+  // их веса — нормированные значения рёбер 1 и 2. Перспективная коррекция
+  // текстуры: 1/w и uv/w линейны в экранных координатах.
+  setup.lighting = m_settings.lighting;
+  for (int c = 0; c < 3; c++) {
+    setup.lightPosition[c] = light.position[c];
+    setup.ambient[c] = material.ambient[c] * light.color[c];
+    setup.diffuse[c] = material.diffuse[c] * light.color[c];
+  }
+  // Без попиксельного освещения world — направления на свет из вершинной
+  // стадии. Gouraud берёт оттуда же косинусы вершин, Flat считает один на
+  // грань; здесь они только умножаются на материал.
+  auto lit = [&](float cosine, int c) {
+    return std::clamp(setup.ambient[c] + setup.diffuse[c] * cosine, 0.0f,
+                      255.0f);
+  };
+  switch (m_settings.lighting) {
+    case LightingModel::Phong:
+      for (int c = 0; c < 3; c++) {
+        setPlane(setup.normal[c], (*t.normal[0])[c], (*t.normal[1])[c],
+                 (*t.normal[2])[c]);
+        setPlane(setup.world[c], (*t.world[0])[c], (*t.world[1])[c],
+                 (*t.world[2])[c]);
       }
-
-      localFaces.push_back(face);
+      break;
+    case LightingModel::Gouraud: {
+      float cosine[3];
+      for (int k = 0; k < 3; k++) {
+        cosine[k] = t.cosine[k] ? *t.cosine[k]
+                                : vertexCosine(*t.normal[k], *t.world[k]);
+      }
+      for (int c = 0; c < 3; c++) {
+        setPlane(setup.lit[c], lit(cosine[0], c), lit(cosine[1], c),
+                 lit(cosine[2], c));
+      }
+      break;
+    }
+    case LightingModel::Flat: {
+      // Нормаль и направление на свет грани — средние по её вершинам.
+      const Normal n =
+          (*t.normal[0] + *t.normal[1] + *t.normal[2]).normalized();
+      const Normal l =
+          (t.world[0]->head<3>() + t.world[1]->head<3>() +
+           t.world[2]->head<3>())
+              .normalized();
+      const float cosine = std::max(n.dot(l), 0.0f);
+      for (int c = 0; c < 3; c++) setup.lit[c][0] = lit(cosine, c);
+      break;
     }
+  }
+  float iw[3];
+  for (int k = 0; k < 3; k++) iw[k] = 1.0f / t.screen[k]->w();
+  setPlane(setup.invW, iw[0], iw[1], iw[2]);
+  for (int c = 0; c < 2; c++) {
+    setPlane(setup.uvw[c], (*t.uv[0])[c] * iw[0], (*t.uv[1])[c] * iw[1],
+             (*t.uv[2])[c] * iw[2]);
+  }
+  if (textured(material)) setupTexture(t, material.texture, setup);
+}
 
-#pragma omp critical
-    faces.insert(faces.end(), localFaces.begin(), localFaces.end());
+void RenderRasterize::setupTexture(const TriangleRef& t,
+                                   const Texture& texture,
+                                   SpanSetup& setup) const {
+  setup.filter = m_settings.textureFilter;
+  int level = 0;
+  float blend = 0.0f;
+  const int maxLevel = texture.levels() - 1;
+  if (setup.filter != TextureFilter::Nearest && maxLevel > 0) {
+    const Vertex& s0 = *t.screen[0];
+    const Vertex& s1 = *t.screen[1];
+    const Vertex& s2 = *t.screen[2];
+    const UVCoordinate& t0 = *t.uv[0];
+    const UVCoordinate& t1 = *t.uv[1];
+    const UVCoordinate& t2 = *t.uv[2];
+    const float screenArea = std::abs((s1.x() - s0.x()) * (s2.y() - s0.y()) -
+                                      (s2.x() - s0.x()) * (s1.y() - s0.y()));
+    const float uvArea = std::abs((t1.x() - t0.x()) * (t2.y() - t0.y()) -
+                                  (t2.x() - t0.x()) * (t1.y() - t0.y()));
+    // Текселей на пиксель по каждой оси — корень отношения площадей.
+    float lod = 0.5f * std::log2(uvArea * float(texture.width_) *
+                                 float(texture.height_) / screenArea);
+    if (!(lod > 0.0f)) lod = 0.0f;  // увеличение и вырожденные (NaN)
+    lod = std::min(lod, float(maxLevel));
+    if (setup.filter == TextureFilter::Trilinear) {
+      level = static_cast<int>(lod);
+      blend = lod - float(level);
+    } else {
+      level = static_cast<int>(lod + 0.5f);
+    }
+  }
+  setup.texture =
+      texture.level(level, setup.textureWidth, setup.textureHeight);
+  if (setup.filter == TextureFilter::Trilinear) {
+    setup.coarseTexture = texture.level(std::min(level + 1, maxLevel),
+                                        setup.coarseWidth, setup.coarseHeight);
+    setup.lodBlend = static_cast<int>(blend * 256.0f);
   }
+}
 
-  cameraObj.getMesh().faces_ = faces;
+bool RenderRasterize::textured(const Material& material) const {
+  return m_settings.texture && !material.texture.colors_.empty();
 }
 
-float RenderRasterize::triangleArea(const Eigen::Vector2i& p1,
-                                    const Eigen::Vector2i& p2,
-                                    const Eigen::Vector2i& p3) {
-  return std::abs((p1.x() * (p2.y() - p3.y()) + p2.x() * (p3.y() - p1.y()) +
-                   p3.x() * (p1.y() - p2.y())) /
-                  2.0f);
+int RenderRasterize::drawTriangle(TriangleRef t, uint32_t triangle,
+                                  const Light& light,
+                                  const Material& material, int xLo, int xHi,
+                                  int yLo, int yHi, int tile,
+                                  SpanOp pass, ShadeSpanFn kernel) {
+  int64_t fx[3], fy[3];
+  const int64_t area = orientTriangle(t, fx, fy);
+  if (area == 0) return 0;  // вырожденный треугольник
+
+  // Пиксель (x, y) берётся в центре: (x + 0.5, y + 0.5).
+  // Прямоугольник зажимаем границами плитки [xLo, xHi) x [yLo, yHi).
+  // Опорный столбец весов не зависит от плитки, так что результат не зависит
+  // ни от разбиения, ни от числа потоков.
+  const PixelBounds px = pixelBounds(fx, fy, xHi, yHi);
+  const int xRef = px.minX;
+  const int minX = std::max(xLo, px.minX);
+  const int maxX = px.maxX;
+  const int minY = std::max(yLo, px.minY);
+  const int maxY = px.maxY;
+  if (minX > maxX || minY > maxY) return 0;
+
+  // Иерархический тест глубины: блоки 8x8, где всё уже ближе ближайшей
+  // вершины, не растеризуются, а если закрыты все — то и весь треугольник.
+  const auto [nearest, farthest] =
+      std::minmax({t.screen[0]->z(), t.screen[1]->z(), t.screen[2]->z()});
+  const int bx0 = (minX - xLo) / kBlockSize;
+  const int by0 = (minY - yLo) / kBlockSize;
+  const int bx1 = (maxX - xLo) / kBlockSize;
+  const int by1 = (maxY - yLo) / kBlockSize;
+  const uint64_t visible =
+      Framebuffer::blockMask(bx0, by0, bx1, by1) &
+      ~_framebuffer.occludedBlocks(tile, bx0, by0, bx1, by1,
+                                   nearest - kHiZEpsilon);
+  if (visible == 0) return 0;
+
+  // Ребро k лежит напротив вершины k, его значение — вес этой вершины.
+  const EdgeFunction edge[3] = {EdgeFunction(fx[1], fy[1], fx[2], fy[2]),
+                                EdgeFunction(fx[2], fy[2], fx[0], fy[0]),
+                                EdgeFunction(fx[0], fy[0], fx[1], fy[1])};
+  const int64_t refX = (int64_t{xRef} << kSubpixelBits) + kSubpixelHalf;
+  const int64_t startY = (int64_t{minY} << kSubpixelBits) + kSubpixelHalf;
+  int64_t row[3];
+  for (int k = 0; k < 3; k++) row[k] = edge[k].at(refX, startY);
+
+  // Веса вершин 1 и 2 — нормированные значения рёбер 1 и 2. Буферу
+  // видимости и предпроходу из плоскостей нужна только глубина.
+  const bool visibility = pass == SpanOp::Visibility;
+  const bool shading =
+      pass == SpanOp::Shade || pass == SpanOp::ShadeEqual;
+  const float invArea = 1.0f / static_cast<float>(area);
+  SpanSetup setup;
+  setup.db1dx = static_cast<float>(edge[1].stepX) * invArea;
+  setup.db2dx = static_cast<float>(edge[2].stepX) * invArea;
+  setPlane(setup.z, t.screen[0]->z(), t.screen[1]->z(), t.screen[2]->z());
+  if (shading) setupShading(t, light, material, setup);
+
+  // Строки плитки идут подряд, столбцы span считаются от xLo.
+  uint32_t* tileColor = _framebuffer.colorTile(tile);
+  std::byte* tileDepth = static_cast<std::byte*>(_framebuffer.depthTile(tile));
+  const size_t depthBytes = Framebuffer::depthBytes(_framebuffer.depthFormat());
+  uint32_t* tileTriangles = nullptr;
+  float* tileWeights[2] = {};
+  if (visibility) {
+    tileTriangles = _framebuffer.triangleTile(tile);
+    tileWeights[0] = _framebuffer.weightTile(tile, 0);
+    tileWeights[1] = _framebuffer.weightTile(tile, 1);
+  }
+  RowSpan span;
+  span.xRef = xRef - xLo;
+  span.depthFormat = _framebuffer.depthFormat();
+  span.triangle = triangle;
+  int band = -1;
+  int bandMinX = 0, bandMaxX = -1;
+  uint64_t touched = 0;  // блоки, куда треугольник писал
+  int written = 0;
+  for (int y = minY; y <= maxY; ++y) {
+    // В полосе из kBlockSize строк рисуем только от первого до последнего
+    // незакрытого блока.
+    if ((y - yLo) / kBlockSize != band) {
+      band = (y - yLo) / kBlockSize;
+      const uint32_t blocks = (visible >> (band * kTileBlocks)) & 0xFF;
+      bandMinX = blocks ? xLo + __builtin_ctz(blocks) * kBlockSize : 1;
+      bandMaxX =
+          blocks ? xLo + (32 - __builtin_clz(blocks)) * kBlockSize - 1 : 0;
+    }
+    // Покрытые столбцы строки считаются точно в целых числах: по каждому
+    // ребру — полупрямая, их пересечение — один отрезок.
+    int64_t lo = std::max(minX, bandMinX) - xRef;
+    int64_t hi = std::min(maxX, bandMaxX) - xRef + 1;
+    for (int k = 0; k < 3; k++) coveredSteps(row[k], edge[k].stepX, lo, hi);
+    if (lo < hi) {
+      const int tileRow = (y - yLo) * kTileSize;
+      span.xBegin = static_cast<int>(xRef + lo) - xLo;
+      span.xEnd = static_cast<int>(xRef + hi) - xLo;
+      span.b1 = static_cast<float>(row[1] - edge[1].bias) * invArea;
+      span.b2 = static_cast<float>(row[2] - edge[2].bias) * invArea;
+      span.color = tileColor + tileRow;
+      span.depth = tileDepth + tileRow * depthBytes;
+      if (visibility) {
+        span.triangles = tileTriangles + tileRow;
+        span.weights[0] = tileWeights[0] + tileRow;
+        span.weights[1] = tileWeights[1] + tileRow;
+      }
+      // Отрезок, не прошедший тест, ничего не меняет — и оценку тоже.
+      // Закраска после предпрохода глубину не понижает.
+      const int passed = kernel(setup, span);
+      written += passed;
+      if (passed && pass != SpanOp::ShadeEqual) {
+        touched |=
+            _framebuffer.coverSpan(tile, y - yLo, span.xBegin, span.xEnd);
+      }
+    }
+    for (int k = 0; k < 3; k++) row[k] += edge[k].stepY;
+  }
+  _framebuffer.commitCoverage(tile, touched, farthest + kHiZEpsilon);
+  return written;
 }
 
-Eigen::Vector3f RenderRasterize::barycentricCoords(const Eigen::Vector2i& p,
-                                                   const Eigen::Vector2i& p0,
-                                                   const Eigen::Vector2i& p1,
-                                                   const Eigen::Vector2i& p2,
-                                                   float area) {
-  float alpha = triangleArea(p, p1, p2) / area;
-  float beta = triangleArea(p0, p, p2) / area;
-  float gamma = triangleArea(p0, p1, p) / area;
-  return Eigen::Vector3f(alpha, beta, gamma);
+void RenderRasterize::clipedObject(const Mesh& mesh, const Matrix4x4& mvp,
+                                   const Face* faces, size_t faceCount,
+                                   bool lighting, ObjectScratch& scratch) {
+  const uint8_t* outcodes = scratch.outcodes.data();
+  auto outsideAll = [&](const Face& f) {
+    return outcodes[f.vertexIndex[0]] & outcodes[f.vertexIndex[1]] &
+           outcodes[f.vertexIndex[2]];
+  };
+  auto outsideAny = [&](const Face& f) {
+    return outcodes[f.vertexIndex[0]] | outcodes[f.vertexIndex[1]] |
+           outcodes[f.vertexIndex[2]];
+  };
+
+  // Все три вершины за одной плоскостью объёма — грань не видна. Если же ни
+  // одна вершина не за ближней/дальней плоскостью и не за защитной полосой,
+  // грань рисуется как есть: края экрана по x/y отрежет растеризатор.
+  resizeScratch(scratch.visibleFaces, faceCount);
+  const size_t kept = compactIf(
+      arena_, faces, faceCount, scratch.visibleFaces.data(), [&](size_t i) {
+        return (outsideAll(faces[i]) & kOutFrustum) == 0 &&
+               (outsideAny(faces[i]) & kOutNeedsClip) == 0;
+      });
+  scratch.visibleFaces.resize(kept);
+
+  // Остальные видимые грани режем. Их обычно единицы, поэтому
+  // последовательно — и порядок треугольников не зависит от потоков.
+  Face* crossing = arena_.allocate<Face>(faceCount);
+  const size_t crossingCount =
+      compactIf(arena_, faces, faceCount, crossing, [&](size_t i) {
+        return (outsideAll(faces[i]) & kOutFrustum) == 0 &&
+               (outsideAny(faces[i]) & kOutNeedsClip) != 0;
+      });
+
+  scratch.clippedTriangles.clear();
+  reserveScratch(scratch.clippedTriangles,
+                 crossingCount * (kMaxClipVertices - 2));
+  const float halfW = 0.5f * _backBuffer.width();
+  const float halfH = 0.5f * _backBuffer.height();
+
+  for (size_t i = 0; i < crossingCount; i++) {
+    const Face& face = crossing[i];
+    ClipVertex polygon[2][kMaxClipVertices];
+    for (int k = 0; k < 3; k++) {
+      const uint32_t vi = face.vertexIndex[k];
+      ClipVertex& v = polygon[0][k];
+      v.clip = mvp * mesh.vertices_[vi];
+      v.world = lighting ? scratch.worldVertices[vi] : Vertex::Zero();
+      v.normal =
+          lighting ? scratch.normals[face.normalIndex[k]] : Normal::Zero();
+      v.uv = mesh.uvCoordinates_[face.uvCoordinateIndex[k]];
+    }
+
+    int count;
+    const ClipVertex* p = clipTriangle(polygon, count);
+
+    // Отсечённый многоугольник выпуклый — режем веером из первой вершины.
+    for (int k = 1; k + 1 < count; k++) {
+      ClippedTriangle t;
+      const ClipVertex* corners[3] = {&p[0], &p[k], &p[k + 1]};
+      for (int c = 0; c < 3; c++) {
+        t.screen[c] = toScreen(corners[c]->clip, halfW, halfH);
+        t.world[c] = corners[c]->world;
+        t.normal[c] = corners[c]->normal;
+        t.uv[c] = corners[c]->uv;
+      }
+      t.materialIndex = face.materialIndex;
+      scratch.clippedTriangles.push_back(t);
+    }
+  }
 }
 }  // namespace s21
\ No newline at end of file
@@ -5,7 +5,9 @@
 #include <mutex>
 #include <vector>
 
+#include "backend/render/frameArena.h"
 #include "backend/render/irender.h"
+#include "backend/render/spanKernel.h"
 
 namespace s21 {
 /**
@@ -28,9 +30,32 @@ class RenderRasterize : public IRender {
    */
   void rendering(Scene& scene) override;
 
+  /**
+   * @brief Сколько раз прошлый кадр обращался к куче за своими буферами.
+   *
+   * Считаются рост буферов объектов и блоков арены. Когда сцена и размер
+   * окна не меняются, значение — 0.
+   */
+  size_t lastFrameAllocations() const { return lastFrameAllocations_; }
+
+  /**
+   * @brief Перекрытие последнего кадра без предпрохода: сколько раз в
+   * среднем закрашивался покрытый гранями пиксель. По нему режим
+   * ShadingPipeline::Auto включает предпроход глубины.
+   */
+  float lastOverdraw() const { return lastOverdraw_; }
+
+  /// Перекрытие, выше которого Auto включает предпроход глубины.
+  static constexpr float kPrepassOverdrawOn = 3.0f;
+  /// Перекрытие, ниже которого Auto предпроход выключает.
+  static constexpr float kPrepassOverdrawOff = 2.5f;
+  /// Через сколько кадров с предпроходом Auto заново меряет перекрытие.
+  static constexpr int kOverdrawProbeFrames = 30;
+
  private:
-  // Копит время кадров и раз в секунду пишет в stderr кадров/с и время кадра.
-  void accountFrame(double frameMs);
+  // Копит время кадров и раз в секунду пишет в stderr кадров/с, время кадра
+  // и число аллокаций за окно.
+  void accountFrame(double frameMs, size_t allocations);
 
   std::chrono::steady_clock::time_point fpsWindowStart_{};
   bool fpsInited_ = false;
@@ -38,152 +63,329 @@ class RenderRasterize : public IRender {
   double fpsMsAccum_ = 0.0;
   double fpsMsMin_ = 0.0;
   double fpsMsMax_ = 0.0;
+  size_t fpsAllocAccum_ = 0;
+
+  /**
+   * @struct ClippedTriangle
+   * @brief Треугольник после отсечения. Его вершины не из меша, поэтому
+   * атрибуты хранятся прямо в нём.
+   */
+  struct ClippedTriangle {
+    Vertex screen[3];        ///< Экранные координаты.
+    Vertex world[3];         ///< Мировые координаты или направления на свет.
+    Normal normal[3];        ///< Нормали в координатах камеры.
+    UVCoordinate uv[3];      ///< Текстурные координаты.
+    uint32_t materialIndex;  ///< Материал исходной грани.
+  };
+
+  /**
+   * @struct ObjectScratch
+   * @brief Производные данные кадра для одного объекта сцены.
+   *
+   * Меши общие и неизменяемые, поэтому всё, что считается для объекта,
+   * пишется сюда. Буферы живут между кадрами и растут только вместе с мешем.
+   */
+  struct ObjectScratch {
+    /// Вершины в мировых координатах; без попиксельного освещения —
+    /// направления из вершины на свет, а у Gouraud в w — косинус угла с
+    /// нормалью vertexNormals[i].
+    std::vector<Vertex> worldVertices;
+    /// Gouraud: индекс нормали, с которой освещена вершина; иначе пуст.
+    std::vector<uint32_t> vertexNormals;
+    std::vector<Vertex> screenVertices;  ///< Вершины в экранных координатах.
+    std::vector<uint8_t> outcodes;  ///< Биты kOut*: за какими плоскостями.
+    std::vector<Normal> normals;    ///< Нормали в координатах камеры.
+    std::vector<Face> visibleFaces;  ///< Грани, не требующие отсечения.
+    /// Треугольники, полученные отсечением пересекающих граней.
+    std::vector<ClippedTriangle> clippedTriangles;
+  };
+
+  /**
+   * @struct ReferencedIndices
+   * @brief Индексы вершин и нормалей, на которые ссылаются видимые грани,
+   * по возрастанию, без повторов. Память — из арены кадра.
+   */
+  struct ReferencedIndices {
+    const uint32_t* vertices = nullptr;  ///< Индексы вершин.
+    size_t vertexCount = 0;              ///< Сколько индексов вершин.
+    const uint32_t* normals = nullptr;   ///< Индексы нормалей.
+    size_t normalCount = 0;              ///< Сколько индексов нормалей.
+  };
+
+  std::vector<ObjectScratch> scratch_;  ///< Буферы по индексу объекта сцены.
+  FrameArena arena_;  ///< Временные участки потоков, сбрасывается каждый кадр.
+  size_t frameAllocations_ = 0;      ///< Аллокаций в текущем кадре.
+  size_t lastFrameAllocations_ = 0;  ///< Аллокаций в прошлом кадре.
+  float lastOverdraw_ = 0.0f;        ///< Перекрытие прошлого кадра.
+  bool prepassActive_ = false;  ///< Включил ли Auto предпроход глубины.
+  int prepassFrames_ = 0;       ///< Кадров с предпроходом после замера.
 
   /**
-   * @brief Преобразует объект в мировые координаты.
+   * @brief Режим закраски кадра: настройка, а для Auto — выбор по
+   * перекрытию прошлых кадров.
    */
-  void transformToWorldCoordinates(const Object& objInput, Object& objOutput);
+  ShadingPipeline framePipeline() const;
+
+  /**
+   * @brief Считает перекрытие кадра и по нему включает или выключает
+   * предпроход в режиме Auto.
+   * @param shaded Сколько пикселей кадра прошло тест глубины.
+   */
+  void updateOverdraw(size_t shaded);
+
+  /**
+   * @brief Задаёт размер буфера объекта, учитывая перевыделение в счётчике.
+   */
+  template <typename T>
+  void resizeScratch(std::vector<T>& buffer, size_t size) {
+    if (size > buffer.capacity()) frameAllocations_++;
+    buffer.resize(size);
+  }
+
+  /**
+   * @brief Резервирует место в буфере объекта, учитывая перевыделение.
+   */
+  template <typename T>
+  void reserveScratch(std::vector<T>& buffer, size_t size) {
+    if (size > buffer.capacity()) frameAllocations_++;
+    buffer.reserve(size);
+  }
+
+  /**
+   * @brief Собирает индексы вершин (и нормалей), на которые ссылаются грани:
+   * параллельная разметка в байтовой карте и сжатие префиксной суммой.
+   * @param normals Нужны ли индексы нормалей (только для освещения).
+   */
+  ReferencedIndices collectReferencedIndices(const Face* faces,
+                                             size_t faceCount,
+                                             const Mesh& mesh, bool normals);
+
+  /**
+   * @brief Пишет в indices номера ненулевых байтов marks по возрастанию.
+   * @return Сколько индексов записано.
+   */
+  size_t compactMarked(const uint8_t* marks, size_t count, uint32_t* indices);
 
   /**
    * @brief Выполняет отсечение невидимых граней методом backface culling.
+   *
+   * Работает в пространстве объекта по плоскостям граней из меша: на грань
+   * одно скалярное произведение с позицией глаза.
    */
-  std::vector<Face> performBackfaceCullingParallel(
-      const std::vector<Face>& faces, const std::vector<Vertex>& vertices,
-      const Vector3F& viewDir);
+  size_t performBackfaceCullingParallel(const Mesh& mesh,
+                                        const Transform& transform,
+                                        const Vector3F& eyePosition,
+                                        Face* culledFaces);
 
   /**
-   * @brief Преобразует объект в координаты камеры.
+   * @brief Вершинная стадия за один параллельный проход: вершина умножается
+   * на готовую MVP, по clip space считаются коды отсечения и экранные
+   * координаты. Обрабатываются только вершины из referenced.
+   * @param lighting Нужны ли мировые вершины (для освещения).
+   * @param light Источник света: при освещении по вершинам или граням
+   * вместо мировых вершин пишутся единичные направления на него.
    */
-  void transformToCameraCoordinates(const Camera& camera,
-                                    const Object& objInput, Object& objOutput);
+  void transformVertices(const Matrix4x4& mvp, const Object& object,
+                         ObjectScratch& scratch, bool lighting,
+                         const Light& light,
+                         const ReferencedIndices& referenced);
 
   /**
-   * @brief Проецирует объект в координаты камеры.
+   * @brief Переводит нормали из referenced сразу в координаты камеры.
    */
-  void projectToCamera(const Camera& camera, const Object& objInput,
-                       Object& objOutput);
+  void transformNormals(const Camera& camera, const Transform& transform,
+                        const MappedVector<Normal>& localNormals,
+                        const ReferencedIndices& referenced,
+                        std::vector<Normal>& globalNormals);
 
   /**
-   * @brief Проецирует объект на экранные координаты.
+   * @brief Освещение по вершинам: косинус угла между нормалью и
+   * направлением на свет — один раз на вершину из referenced, в w её
+   * мировой вершины.
+   *
+   * Вершина берёт нормаль одного из своих углов среди faces; углы с другой
+   * нормалью (острые рёбра) досчитываются при настройке треугольника.
    */
-  void projectToScreen(const Object& objInput,
-                       std::vector<Vertex>& screenVertex);
+  void lightVertices(const Face* faces, size_t faceCount,
+                     const ReferencedIndices& referenced,
+                     ObjectScratch& scratch);
 
   /**
    * @brief Растеризует меш с использованием второго метода.
    */
-  void rasterizeMesh2(const Mesh& mesh, std::vector<Vertex>& screenVertex,
-                      const Scene& scene);
+  void rasterizeMesh2(const ObjectScratch& scratch);
+
+  /**
+   * @brief Рисует рёбра и вершины одного треугольника.
+   */
+  void drawWireTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
   /**
    * @brief Отрисовывает точку в виде круга.
    */
   void drawPointAsCircle(const Vertex& center);
 
+  /**
+   * @struct TileBins
+   * @brief Списки треугольников по плиткам экрана. Память — из арены кадра.
+   *
+   * Треугольник с номером i < visibleFaces.size() — грань visibleFaces[i],
+   * остальные — clippedTriangles[i - visibleFaces.size()].
+   */
+  struct TileBins {
+    int tilesX = 0;  ///< Плиток по горизонтали.
+    int tilesY = 0;  ///< Плиток по вертикали.
+    /// Треугольники плитки t — triangles[offsets[t] .. offsets[t + 1]).
+    const uint32_t* offsets = nullptr;
+    const uint32_t* triangles = nullptr;  ///< Номера треугольников.
+    float nearest = 1.0f;  ///< Глубина ближайшей вершины на экране.
+    /// Глубина ближайшей вершины группы из kClusterSize треугольников;
+    /// null, если кадр без предпрохода.
+    const float* clusterNearest = nullptr;
+  };
+
   /**
    * @brief Растеризует меш, используя переданные вершины.
+   *
+   * Треугольники разложены по плиткам экрана (binTriangles), и потоки
+   * берут плитки целиком: каждая плитка рисует только свои треугольники.
+   * Ядра отрезков под операцию pass и формат глубины выбираются один раз на
+   * вызов, под текстуру — по материалу треугольника.
+   * @param firstTriangle Номер в кадре первого треугольника объекта.
+   * @return Сколько пикселей прошло тест глубины.
    */
-  void rasterizeMesh(const Mesh& mesh, std::vector<Vertex>& screenVertex,
-                     const std::vector<Vertex>& globalVertex,
-                     const Scene& scene);
+  size_t rasterizeMesh(const Mesh& mesh, const ObjectScratch& scratch,
+                       const Scene& scene, const TileBins& bins,
+                       uint32_t firstTriangle, SpanOp pass);
 
   /**
-   * @brief Рисует линию между двумя точками.
+   * @brief Закрашивает буфер видимости: каждый видимый пиксель освещается и
+   * текстурируется один раз, сколько бы треугольников его ни перекрывало.
+   * @param firstTriangle Номера первых треугольников объектов в кадре.
    */
-  void drawLine(const Vertex& p1, const Vertex& p2);
+  void shadeVisibleTriangles(Scene& scene, const uint32_t* firstTriangle);
 
   /**
-   * @brief Рисует треугольник с учетом освещения и текстурирования.
+   * @struct TriangleRef
+   * @brief Вершины треугольника и их атрибуты — указатели в меш и буферы
+   * объекта.
    */
-  void drawTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
-                    const UVCoordinate texture_coord_0,
-                    const UVCoordinate texture_coord_1,
-                    const UVCoordinate texture_coord_2, const Normal normal0,
-                    const Normal normal1, const Normal normal3,
-                    const Vertex& vg1, const Vertex& vg2, const Vertex& vg3,
-                    const Light& light, const Material& material, int yLo,
-                    int yHi, unsigned char* bits, qsizetype bpl, int W, int H);
+  struct TriangleRef {
+    const Vertex* screen[3];     ///< Экранные координаты.
+    const UVCoordinate* uv[3];   ///< Текстурные координаты.
+    const Normal* normal[3];     ///< Нормали в координатах камеры.
+    const Vertex* world[3];      ///< Мировые координаты.
+    /// Gouraud: готовый косинус угла или null — посчитать по normal, world.
+    const float* cosine[3] = {};
+    uint32_t materialIndex = 0;  ///< Материал.
+  };
 
   /**
-   * @brief Вычисляет освещение по модели Фонга для вершины.
+   * @brief Треугольник с номером id в нумерации TileBins.
    */
-  Eigen::Vector3f calculatePhongIlluminationForVertex(
-      const Vertex& v, const Normal& n, const Material& material,
-      const Light& light, const Eigen::Vector3f& viewPos);
+  static TriangleRef triangleAt(const Mesh& mesh, const ObjectScratch& scratch,
+                                uint32_t id);
 
   /**
-   * @brief Выполняет отсечение объекта.
+   * @brief Косинус угла между нормалью n и направлением на свет toLight,
+   * не меньше нуля. Один код для вершинной стадии и настройки треугольника.
    */
-  void clipedObject(const Camera& camera, Object& cameraObj);
+  static float vertexCosine(const Normal& n, const Vertex& toLight);
 
   /**
-   * @brief Отрисовывает точку в виде квадрата.
+   * @brief Переводит вершины t в фиксированную точку (fx, fy) и при обратном
+   * обходе меняет местами вершины 1 и 2.
+   * @return Удвоенная площадь в единицах субпикселя, не меньше нуля.
    */
-  void drawPointAsSquar(const Vertex& center);
+  static int64_t orientTriangle(TriangleRef& t, int64_t fx[3], int64_t fy[3]);
 
   /**
-   * @brief Проецирует объект в координаты камеры и выполняет отсечение.
+   * @brief Заполняет плоскости освещения и текстуры SpanSetup для
+   * упорядоченного orientTriangle() треугольника.
    */
-  Object projectToCameraCoordinatesAndClip(const Object& globalObject,
-                                           Camera& camera);
+  void setupShading(const TriangleRef& t, const Light& light,
+                    const Material& material, SpanSetup& setup) const;
 
   /**
-   * @brief Проецирует вершины в координаты камеры.
+   * @brief Заполняет уровни текстуры SpanSetup: уровень детализации — log2
+   * числа текселей на пиксель, оценённого по площадям треугольника.
    */
-  void projectToCameraCoordinates(const std::vector<Vertex>& worldVertices,
-                                  std::vector<Vertex>& screenVertices,
-                                  const Camera& camera);
+  void setupTexture(const TriangleRef& t, const Texture& texture,
+                    SpanSetup& setup) const;
 
   /**
-   * @brief Проецирует вершины в экранные координаты.
+   * @brief Закрашиваются ли грани материала с текстурой: она включена в
+   * настройках и загружена.
    */
-  void projectToScreenCoordinates(const std::vector<Vertex>& screenVertices,
-                                  std::vector<Vertex>& finalScreenVertices,
-                                  const Camera& camera);
+  bool textured(const Material& material) const;
 
- private:
   /**
-   * @brief Вычисляет амбиентное освещение.
+   * @brief Раскладывает треугольники объекта по плиткам: параллельный подсчёт,
+   * префиксная сумма и запись. В каждой плитке треугольники идут в исходном
+   * порядке.
+   * @param clusterDepth Считать ли TileBins::clusterNearest — он нужен
+   * только предпроходу глубины.
    */
-  Eigen::Vector3f calculateAmbient(const Material& material,
-                                   const Light& light);
+  TileBins binTriangles(const ObjectScratch& scratch, int W, int H,
+                        bool clusterDepth);
 
   /**
-   * @brief Вычисляет диффузное освещение.
+   * @brief Рисует линию между двумя точками.
    */
-  Eigen::Vector3f calculateDiffuse(const Material& material, const Light& light,
-                                   const Normal& normal,
-                                   const Eigen::Vector3f& lightDir);
+  void drawLine(const Vertex& p1, const Vertex& p2);
 
   /**
-   * @brief Вычисляет площадь треугольника.
+   * @brief Рисует треугольник с учетом освещения и текстурирования.
+   *
+   * Растеризация по полуплоскостям: уравнения рёбер в фиксированной точке
+   * (1/16 пикселя) и приращения атрибутов задаются один раз на треугольник,
+   * дальше значения идут шагами по строке. Заливка по правилу верхнего-левого
+   * ребра. Покрытый отрезок строки считается точно и обрабатывается ядром
+   * kernel операции pass прямо в плитке буфера кадра. Блоки плитки, закрытые по
+   * иерархической глубине, пропускаются.
+   * @param triangle Номер треугольника в кадре (для буфера видимости).
+   * @param tile Плитка буфера кадра [xLo, xHi) x [yLo, yHi).
+   * @return Сколько пикселей прошло тест глубины.
    */
-  float triangleArea(const Eigen::Vector2i& p1, const Eigen::Vector2i& p2,
-                     const Eigen::Vector2i& p3);
+  int drawTriangle(TriangleRef t, uint32_t triangle, const Light& light,
+                   const Material& material, int xLo, int xHi, int yLo,
+                   int yHi, int tile, SpanOp pass, ShadeSpanFn kernel);
 
   /**
-   * @brief Вычисляет барицентрические координаты.
+   * @brief Отсекает грани по видимому объёму.
+   *
+   * Грани целиком за одной из плоскостей объёма отбрасываются. Грани,
+   * задевающие ближнюю/дальнюю плоскость или защитную полосу, режутся в clip
+   * space (Сазерленд–Ходжмен) в scratch.clippedTriangles. Остальные попадают
+   * в scratch.visibleFaces как есть: по x/y их отрезает растеризатор.
    */
-  Eigen::Vector3f barycentricCoords(const Eigen::Vector2i& p,
-                                    const Eigen::Vector2i& p0,
-                                    const Eigen::Vector2i& p1,
-                                    const Eigen::Vector2i& p2, float area);
+  void clipedObject(const Mesh& mesh, const Matrix4x4& mvp, const Face* faces,
+                    size_t faceCount, bool lighting, ObjectScratch& scratch);
 
   /**
-   * @brief Интерполирует значение с использованием барицентрических координат.
+   * @brief Отрисовывает точку в виде квадрата.
    */
-  template <typename T>
-  T interpolate(const T& v0, const T& v1, const T& v2,
-                const Eigen::Vector3f& baryCoords);
-};
+  void drawPointAsSquar(const Vertex& center);
 
-/**
- * @brief Шаблонная функция интерполяции значений.
- */
-template <typename T>
-T RenderRasterize::interpolate(const T& v0, const T& v1, const T& v2,
-                               const Eigen::Vector3f& baryCoords) {
-  return baryCoords[0] * v0 + baryCoords[1] * v1 + baryCoords[2] * v2;
-}
+  /**
+   * @brief Проецирует объект в координаты камеры и выполняет отсечение.
+   */
+  Object projectToCameraCoordinatesAndClip(const Object& globalObject,
+                                           Camera& camera);
+
+  /**
+   * @brief Проецирует вершины в координаты камеры.
+   */
+  void projectToCameraCoordinates(const std::vector<Vertex>& worldVertices,
+                                  std::vector<Vertex>& screenVertices,
+                                  const Camera& camera);
+
+  /**
+   * @brief Проецирует вершины в экранные координаты.
+   */
+  void projectToScreenCoordinates(const std::vector<Vertex>& screenVertices,
+                                  std::vector<Vertex>& finalScreenVertices,
+                                  const Camera& camera);
+};
 }  // namespace s21
 #endif
\ No newline at end of file
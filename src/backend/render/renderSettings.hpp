@@ -4,9 +4,21 @@
 #include <fstream>
 #include <iostream>
 
+#include "backend/render/spanKernel.h"
 #include "backend/types.h"
 
 namespace s21 {
+/**
+ * @enum ShadingPipeline
+ * @brief Как закрашиваются грани.
+ */
+enum class ShadingPipeline : int {
+  Forward,           ///< Пиксель закрашивается сразу, как прошёл тест глубины.
+  VisibilityBuffer,  ///< Сначала видимость, потом закраска видимых пикселей.
+  DepthPrepass,  ///< Сначала только глубина, потом закраска на равенство.
+  Auto,  ///< Forward или DepthPrepass — по перекрытию прошлого кадра.
+};
+
 /**
  * @struct RenderSettings
  * @brief Структура, содержащая параметры рендеринга.
@@ -25,6 +37,15 @@ struct RenderSettings {
 
   bool renderFace = true;  ///< Флаг рендеринга граней.
   bool texture = true;     ///< Флаг рендеринга текстур.
+  /// Закраска граней: при сильном перекрытии буфер видимости освещает и
+  /// текстурирует каждый пиксель один раз.
+  ShadingPipeline shadingPipeline = ShadingPipeline::Forward;
+  /// Освещение граней: по вершинам и по граням пиксель только
+  /// интерполирует цвет — быстрее попиксельного для больших моделей.
+  LightingModel lighting = LightingModel::Phong;
+  /// Фильтр текстур: Bilinear и Trilinear берут уровень mip-цепочки по
+  /// уменьшению треугольника, без мерцания на удалённых гранях.
+  TextureFilter textureFilter = TextureFilter::Nearest;
 
   /**
    * @brief Сохраняет настройки рендеринга в файл.
@@ -41,7 +62,10 @@ struct RenderSettings {
     file << renderDot << " " << vertexColor.x() << " " << vertexColor.y() << " "
          << vertexColor.z() << " " << vertexSize << " " << renderLine << " "
          << lineColor.x() << " " << lineColor.y() << " " << lineColor.z() << " "
-         << renderFace << " " << texture << "\n";
+         << renderFace << " " << texture << " "
+         << static_cast<int>(shadingPipeline) << " "
+         << static_cast<int>(lighting) << " "
+         << static_cast<int>(textureFilter) << "\n";
 
     file.close();
     return true;
@@ -62,6 +86,15 @@ struct RenderSettings {
     file >> renderDot >> vertexColor.x() >> vertexColor.y() >>
         vertexColor.z() >> vertexSize >> renderLine >> lineColor.x() >>
         lineColor.y() >> lineColor.z() >> renderFace >> texture;
+    // В старых файлах полей нет — остаются прежние значения.
+    int pipeline = static_cast<int>(shadingPipeline);
+    if (file >> pipeline) {
+      shadingPipeline = static_cast<ShadingPipeline>(pipeline);
+    }
+    int model = static_cast<int>(lighting);
+    if (file >> model) lighting = static_cast<LightingModel>(model);
+    int filter = static_cast<int>(textureFilter);
+    if (file >> filter) textureFilter = static_cast<TextureFilter>(filter);
 
     file.close();
     return true;
@@ -0,0 +1,815 @@
+#include "spanKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef S21_SPAN_AVX2
+#include <immintrin.h>
+#endif
+
+// Ядра обязаны давать одинаковые биты, поэтому компилятору нельзя сливать
+// умножение и сложение в FMA: под -march=native он это делает, и результат
+// зависел бы от того, в каком ядре и где ему это удалось.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace s21 {
+namespace {
+// Значение атрибута по весам вершин 1 и 2 (см. SpanSetup).
+inline float planeAt(const float* a, float b1, float b2) {
+  return (a[0] + b1 * a[1]) + b2 * a[2];
+}
+
+inline uint32_t packArgb(int r, int g, int b) {
+  return 0xFF000000u | (static_cast<uint32_t>(r) << 16) |
+         (static_cast<uint32_t>(g) << 8) | static_cast<uint32_t>(b);
+}
+
+constexpr float kUnorm24Max = 16777215.0f;
+constexpr float kUnorm16Max = 65535.0f;
+
+// Глубина NDC [-1, 1] -> [0, 1] -> целое [0, max], с отбрасыванием дробной
+// части. AVX2-ядро считает в том же порядке.
+inline uint32_t toUnorm(float depth, float max) {
+  const float d = std::min(std::max(depth * 0.5f + 0.5f, 0.0f), 1.0f);
+  return static_cast<uint32_t>(d * max);
+}
+
+// Тест глубины для значения stored в буфере. Обычный: пиксель ближе —
+// пишется его глубина. На равенство (kEqual, закраска после предпрохода
+// глубины): пиксель достаётся первому треугольнику с глубиной из буфера, а
+// в буфер пишется значение очистки far — так остальные треугольники с той
+// же глубиной его не перекрасят. Глубина far предпроход не проходит.
+template <bool kEqual, typename T, typename V>
+inline bool testStored(T& stored, V depth, T far) {
+  if constexpr (kEqual) {
+    if (depth != stored || stored == far) return false;
+    stored = far;
+  } else {
+    if (depth >= stored) return false;
+    stored = static_cast<T>(depth);
+  }
+  return true;
+}
+
+// Тест глубины в столбце x; значения очистки — как в Framebuffer::clearTile.
+template <DepthFormat kFormat, bool kEqual>
+inline bool depthTest(const RowSpan& span, int x, float depth) {
+  if constexpr (kFormat == DepthFormat::Unorm24) {
+    return testStored<kEqual>(static_cast<uint32_t*>(span.depth)[x],
+                              toUnorm(depth, kUnorm24Max), 0xFFFFFFu);
+  } else if constexpr (kFormat == DepthFormat::Unorm16) {
+    return testStored<kEqual>(static_cast<uint16_t*>(span.depth)[x],
+                              toUnorm(depth, kUnorm16Max), uint16_t{0xFFFF});
+  } else {
+    return testStored<kEqual>(static_cast<float*>(span.depth)[x], depth,
+                              1.0f);
+  }
+}
+
+// Освещённый цвет пикселя с весами b1, b2 по каналам, в [0, 255].
+template <LightingModel kLighting>
+inline void litColor(const SpanSetup& s, float b1, float b2, float color[3]) {
+  if constexpr (kLighting == LightingModel::Gouraud) {
+    for (int c = 0; c < 3; c++) color[c] = planeAt(s.lit[c], b1, b2);
+  } else if constexpr (kLighting == LightingModel::Flat) {
+    for (int c = 0; c < 3; c++) color[c] = s.lit[c][0];
+  } else {
+    const float nx = planeAt(s.normal[0], b1, b2);
+    const float ny = planeAt(s.normal[1], b1, b2);
+    const float nz = planeAt(s.normal[2], b1, b2);
+    float lx = s.lightPosition[0] - planeAt(s.world[0], b1, b2);
+    float ly = s.lightPosition[1] - planeAt(s.world[1], b1, b2);
+    float lz = s.lightPosition[2] - planeAt(s.world[2], b1, b2);
+    const float length = std::sqrt((lx * lx + ly * ly) + lz * lz);
+    if (length > 0.0f) {
+      lx = lx / length;
+      ly = ly / length;
+      lz = lz / length;
+    }
+    const float cosine = std::max((nx * lx + ny * ly) + nz * lz, 0.0f);
+    for (int c = 0; c < 3; c++) {
+      color[c] = std::max(
+          std::min(s.ambient[c] + s.diffuse[c] * cosine, 255.0f), 0.0f);
+    }
+  }
+}
+
+// Координата текселя u * (size - 1) в 1/256 текселя, зажатая в
+// [0, size - 1]; NaN даёт 0. Тексель i лежит в целой координате i: старшие
+// биты — левый из двух смешиваемых, младшие 8 — вес правого.
+inline int texelCoordFixed(float u, int size) {
+  const float max = static_cast<float>(size - 1);
+  return static_cast<int>(std::min(std::max(0.0f, u * max), max) * 256.0f);
+}
+
+// a + (b - a) * w / 256 для всех четырёх каналов RGBA8 разом: R, B и G, A
+// лежат в 16-битных половинах слова, и при весах, дающих в сумме 256,
+// произведения из своих половин не выходят.
+inline uint32_t lerpTexel(uint32_t a, uint32_t b, uint32_t w) {
+  constexpr uint32_t kMask = 0x00FF00FFu;
+  const uint32_t iw = 256 - w;
+  const uint32_t rb = (((a & kMask) * iw + (b & kMask) * w) >> 8) & kMask;
+  const uint32_t ga =
+      (((a >> 8) & kMask) * iw + ((b >> 8) & kMask) * w) & ~kMask;
+  return rb | ga;
+}
+
+// Билинейная выборка из уровня width x height в фиксированной точке.
+inline uint32_t sampleBilinear(const uint32_t* texture, int width, int height,
+                               float u, float v) {
+  const int fx = texelCoordFixed(u, width);
+  const int fy = texelCoordFixed(v, height);
+  const int x0 = fx >> 8;
+  const int y0 = fy >> 8;
+  const int x1 = std::min(x0 + 1, width - 1);
+  const int y1 = std::min(y0 + 1, height - 1);
+  const uint32_t top = lerpTexel(texture[y0 * width + x0],
+                                 texture[y0 * width + x1], fx & 0xFF);
+  const uint32_t bottom = lerpTexel(texture[y1 * width + x0],
+                                    texture[y1 * width + x1], fx & 0xFF);
+  return lerpTexel(top, bottom, fy & 0xFF);
+}
+
+// Тексель RGBA8 в точке (u, v) с фильтром kFilter.
+template <TextureFilter kFilter>
+inline uint32_t sampleTexture(const SpanSetup& s, float u, float v) {
+  if constexpr (kFilter == TextureFilter::Nearest) {
+    const float texMaxU = static_cast<float>(s.textureWidth - 1);
+    const float texMaxV = static_cast<float>(s.textureHeight - 1);
+    const int tx =
+        std::clamp(static_cast<int>(u * texMaxU), 0, s.textureWidth - 1);
+    const int ty =
+        std::clamp(static_cast<int>(v * texMaxV), 0, s.textureHeight - 1);
+    return s.texture[ty * s.textureWidth + tx];
+  } else {
+    const uint32_t texel =
+        sampleBilinear(s.texture, s.textureWidth, s.textureHeight, u, v);
+    if constexpr (kFilter == TextureFilter::Trilinear) {
+      return lerpTexel(texel,
+                       sampleBilinear(s.coarseTexture, s.coarseWidth,
+                                      s.coarseHeight, u, v),
+                       static_cast<uint32_t>(s.lodBlend));
+    }
+    return texel;
+  }
+}
+
+// Освещение и текстура пикселя с весами b1, b2: общая часть ядер после
+// теста глубины.
+template <LightingModel kLighting, bool kTextured, TextureFilter kFilter>
+inline uint32_t shadePixel(const SpanSetup& s, float b1, float b2) {
+  float color[3];
+  litColor<kLighting>(s, b1, b2, color);
+  int rgb[3];
+  for (int c = 0; c < 3; c++) {
+    rgb[c] = std::clamp(static_cast<int>(color[c]), 0, 255);
+  }
+
+  if constexpr (kTextured) {
+    const float r = 1.0f / planeAt(s.invW, b1, b2);
+    const float u = planeAt(s.uvw[0], b1, b2) * r;
+    const float v = planeAt(s.uvw[1], b1, b2) * r;
+    const uint32_t texel = sampleTexture<kFilter>(s, u, v);
+    for (int c = 0; c < 3; c++) {
+      // rgb * texel / 255 с округлением, без деления.
+      const int x = rgb[c] * static_cast<int>((texel >> (8 * c)) & 0xFF) + 128;
+      rgb[c] = (x + (x >> 8)) >> 8;
+    }
+  }
+
+  return packArgb(rgb[0], rgb[1], rgb[2]);
+}
+}  // namespace
+
+namespace {
+// Скалярное ядро отрезка для операции kOp, формата глубины kFormat,
+// освещения kLighting и текстуры kTextured с фильтром kFilter: всё выбрано
+// при компиляции, на пиксель ветвлений нет.
+template <SpanOp kOp, DepthFormat kFormat, LightingModel kLighting,
+          bool kTextured, TextureFilter kFilter>
+int spanScalar(const SpanSetup& s, const RowSpan& span) {
+  int written = 0;
+  for (int x = span.xBegin; x < span.xEnd; ++x) {
+    const float t = static_cast<float>(x - span.xRef);
+    const float b1 = span.b1 + t * s.db1dx;
+    const float b2 = span.b2 + t * s.db2dx;
+
+    if (!depthTest<kFormat, kOp == SpanOp::ShadeEqual>(
+            span, x, planeAt(s.z, b1, b2))) {
+      continue;
+    }
+    ++written;
+    if constexpr (kOp == SpanOp::Visibility) {
+      span.triangles[x] = span.triangle;
+      span.weights[0][x] = b1;
+      span.weights[1][x] = b2;
+    } else if constexpr (kOp != SpanOp::Depth) {
+      span.color[x] = shadePixel<kLighting, kTextured, kFilter>(s, b1, b2);
+    }
+  }
+  return written;
+}
+
+template <LightingModel kLighting, bool kTextured, TextureFilter kFilter>
+void shadePixelsScalarWith(const SpanSetup& s, const float* b1,
+                           const float* b2, uint32_t* color, int count) {
+  for (int i = 0; i < count; ++i) {
+    color[i] = shadePixel<kLighting, kTextured, kFilter>(s, b1[i], b2[i]);
+  }
+}
+
+// Ядра одного набора инструкций как шаблон переменной: по нему собирается
+// таблица SpanKernels.
+struct ScalarIsa {
+  template <SpanOp kOp, DepthFormat kFormat, LightingModel kLighting,
+            bool kTextured, TextureFilter kFilter>
+  static constexpr ShadeSpanFn kSpan =
+      spanScalar<kOp, kFormat, kLighting, kTextured, kFilter>;
+  template <LightingModel kLighting, bool kTextured, TextureFilter kFilter>
+  static constexpr ShadePixelsFn kPixels =
+      shadePixelsScalarWith<kLighting, kTextured, kFilter>;
+};
+
+// Параметры ядер, выбираемые во время работы: по ним шаблоны ниже по
+// одному переключателю на параметр спускаются к нужному экземпляру.
+struct KernelParams {
+  SpanOp op;
+  DepthFormat format;
+  LightingModel lighting;
+  TextureFilter filter;
+};
+
+template <typename Isa, SpanOp kOp, DepthFormat kFormat,
+          LightingModel kLighting>
+SpanKernels kernelsFor(TextureFilter filter) {
+  constexpr TextureFilter kNearest = TextureFilter::Nearest;
+  const ShadeSpanFn plain =
+      Isa::template kSpan<kOp, kFormat, kLighting, false, kNearest>;
+  switch (filter) {
+    case TextureFilter::Bilinear:
+      return {plain, Isa::template kSpan<kOp, kFormat, kLighting, true,
+                                         TextureFilter::Bilinear>};
+    case TextureFilter::Trilinear:
+      return {plain, Isa::template kSpan<kOp, kFormat, kLighting, true,
+                                         TextureFilter::Trilinear>};
+    case TextureFilter::Nearest:
+      break;
+  }
+  return {plain, Isa::template kSpan<kOp, kFormat, kLighting, true, kNearest>};
+}
+
+template <typename Isa, SpanOp kOp, DepthFormat kFormat>
+SpanKernels kernelsFor(const KernelParams& p) {
+  // Без закраски освещение и текстура не нужны: хватает одного ядра.
+  if constexpr (kOp == SpanOp::Visibility || kOp == SpanOp::Depth) {
+    const ShadeSpanFn kernel =
+        Isa::template kSpan<kOp, kFormat, LightingModel::Phong, false,
+                            TextureFilter::Nearest>;
+    return {kernel, kernel};
+  } else {
+    switch (p.lighting) {
+      case LightingModel::Gouraud:
+        return kernelsFor<Isa, kOp, kFormat, LightingModel::Gouraud>(
+            p.filter);
+      case LightingModel::Flat:
+        return kernelsFor<Isa, kOp, kFormat, LightingModel::Flat>(p.filter);
+      case LightingModel::Phong:
+        break;
+    }
+    return kernelsFor<Isa, kOp, kFormat, LightingModel::Phong>(p.filter);
+  }
+}
+
+template <typename Isa, SpanOp kOp>
+SpanKernels kernelsFor(const KernelParams& p) {
+  switch (p.format) {
+    case DepthFormat::Unorm24:
+      return kernelsFor<Isa, kOp, DepthFormat::Unorm24>(p);
+    case DepthFormat::Unorm16:
+      return kernelsFor<Isa, kOp, DepthFormat::Unorm16>(p);
+    case DepthFormat::Float32:
+      break;
+  }
+  return kernelsFor<Isa, kOp, DepthFormat::Float32>(p);
+}
+
+template <typename Isa>
+SpanKernels kernelsFor(const KernelParams& p) {
+  switch (p.op) {
+    case SpanOp::Visibility:
+      return kernelsFor<Isa, SpanOp::Visibility>(p);
+    case SpanOp::Depth:
+      return kernelsFor<Isa, SpanOp::Depth>(p);
+    case SpanOp::ShadeEqual:
+      return kernelsFor<Isa, SpanOp::ShadeEqual>(p);
+    case SpanOp::Shade:
+      break;
+  }
+  return kernelsFor<Isa, SpanOp::Shade>(p);
+}
+
+template <typename Isa, LightingModel kLighting>
+ShadePixelsFn pixelsFor(TextureFilter filter, bool textured) {
+  if (!textured) {
+    return Isa::template kPixels<kLighting, false, TextureFilter::Nearest>;
+  }
+  switch (filter) {
+    case TextureFilter::Bilinear:
+      return Isa::template kPixels<kLighting, true, TextureFilter::Bilinear>;
+    case TextureFilter::Trilinear:
+      return Isa::template kPixels<kLighting, true, TextureFilter::Trilinear>;
+    case TextureFilter::Nearest:
+      break;
+  }
+  return Isa::template kPixels<kLighting, true, TextureFilter::Nearest>;
+}
+
+template <typename Isa>
+ShadePixelsFn pixelsFor(LightingModel lighting, TextureFilter filter,
+                        bool textured) {
+  switch (lighting) {
+    case LightingModel::Gouraud:
+      return pixelsFor<Isa, LightingModel::Gouraud>(filter, textured);
+    case LightingModel::Flat:
+      return pixelsFor<Isa, LightingModel::Flat>(filter, textured);
+    case LightingModel::Phong:
+      break;
+  }
+  return pixelsFor<Isa, LightingModel::Phong>(filter, textured);
+}
+
+// Общие точки входа: ядро выбирается по отрезку и setup на каждый вызов.
+template <typename Isa>
+int runSpan(SpanOp op, const SpanSetup& s, const RowSpan& span) {
+  const SpanKernels kernels =
+      kernelsFor<Isa>({op, span.depthFormat, s.lighting, s.filter});
+  return (s.texture ? kernels.textured : kernels.plain)(s, span);
+}
+}  // namespace
+
+int shadeSpanScalar(const SpanSetup& s, const RowSpan& span) {
+  return runSpan<ScalarIsa>(SpanOp::Shade, s, span);
+}
+
+int shadeSpanEqualScalar(const SpanSetup& s, const RowSpan& span) {
+  return runSpan<ScalarIsa>(SpanOp::ShadeEqual, s, span);
+}
+
+int writeDepthScalar(const SpanSetup& s, const RowSpan& span) {
+  return runSpan<ScalarIsa>(SpanOp::Depth, s, span);
+}
+
+int writeVisibilityScalar(const SpanSetup& s, const RowSpan& span) {
+  return runSpan<ScalarIsa>(SpanOp::Visibility, s, span);
+}
+
+void shadePixelsScalar(const SpanSetup& s, const float* b1, const float* b2,
+                       uint32_t* color, int count) {
+  pixelsFor<ScalarIsa>(s.lighting, s.filter, s.texture != nullptr)(
+      s, b1, b2, color, count);
+}
+
+#ifdef S21_SPAN_AVX2
+namespace {
+struct PlaneAvx2 {
+  __m256 a0, a1, a2;
+};
+
+__attribute__((target("avx2"))) inline PlaneAvx2 loadPlane(const float* a) {
+  return {_mm256_set1_ps(a[0]), _mm256_set1_ps(a[1]), _mm256_set1_ps(a[2])};
+}
+
+__attribute__((target("avx2"))) inline __m256 planeAt(const PlaneAvx2& p,
+                                                      __m256 b1, __m256 b2) {
+  return _mm256_add_ps(_mm256_add_ps(p.a0, _mm256_mul_ps(b1, p.a1)),
+                       _mm256_mul_ps(b2, p.a2));
+}
+
+// Тот же std::clamp(int(x), lo, hi), что в скалярном ядре.
+__attribute__((target("avx2"))) inline __m256i truncClamp(__m256 x, int lo,
+                                                          int hi) {
+  return _mm256_min_epi32(
+      _mm256_max_epi32(_mm256_cvttps_epi32(x), _mm256_set1_epi32(lo)),
+      _mm256_set1_epi32(hi));
+}
+
+// Тот же toUnorm, что в скалярном ядре.
+__attribute__((target("avx2"))) inline __m256i toUnorm(__m256 depth,
+                                                       float max) {
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 d = _mm256_min_ps(
+      _mm256_set1_ps(1.0f),
+      _mm256_max_ps(_mm256_setzero_ps(),
+                    _mm256_add_ps(_mm256_mul_ps(depth, half), half)));
+  return _mm256_cvttps_epi32(_mm256_mul_ps(d, _mm256_set1_ps(max)));
+}
+
+// Маска прошедших тест дорожек среди inSpan: stored и value — целые
+// глубины, far — значение очистки. См. скалярный testStored().
+template <bool kEqual>
+__attribute__((target("avx2"))) inline __m256i passMask(__m256i inSpan,
+                                                        __m256i stored,
+                                                        __m256i value,
+                                                        __m256i far) {
+  if constexpr (kEqual) {
+    return _mm256_andnot_si256(
+        _mm256_cmpeq_epi32(stored, far),
+        _mm256_and_si256(inSpan, _mm256_cmpeq_epi32(stored, value)));
+  } else {
+    return _mm256_and_si256(inSpan, _mm256_cmpgt_epi32(stored, value));
+  }
+}
+
+// Тест глубины для столбцов x0..x0+7 из маски inSpan; прошедшие пишут
+// глубину (при kEqual — значение очистки). Возвращает маску прошедших.
+template <DepthFormat kFormat, bool kEqual>
+__attribute__((target("avx2"))) inline __m256i depthTestAvx2(
+    const RowSpan& span, int x0, __m256 depth, __m256i inSpan) {
+  if constexpr (kFormat == DepthFormat::Unorm24) {
+    int* row = static_cast<int*>(span.depth) + x0;
+    const __m256i q = toUnorm(depth, kUnorm24Max);
+    const __m256i far = _mm256_set1_epi32(0xFFFFFF);
+    // Значения меньше 2^24, так что знаковое сравнение годится.
+    const __m256i stored = _mm256_maskload_epi32(row, inSpan);
+    const __m256i pass = passMask<kEqual>(inSpan, stored, q, far);
+    _mm256_maskstore_epi32(row, pass, kEqual ? far : q);
+    return pass;
+  } else if constexpr (kFormat == DepthFormat::Unorm16) {
+    // Для 16 бит маскированных чтения и записи нет: читаем 8 значений
+    // целиком, а у конца отрезка — через копию, чтобы не задеть соседнюю
+    // плитку (её пишет другой поток).
+    uint16_t* row = static_cast<uint16_t*>(span.depth) + x0;
+    const int count = std::min(8, span.xEnd - x0);
+    alignas(16) uint16_t tail[8] = {};
+    uint16_t* io = row;
+    if (count < 8) {
+      std::memcpy(tail, row, count * sizeof(uint16_t));
+      io = tail;
+    }
+    const __m256i q = toUnorm(depth, kUnorm16Max);
+    const __m256i far = _mm256_set1_epi32(0xFFFF);
+    const __m256i stored = _mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(io)));
+    const __m256i pass = passMask<kEqual>(inSpan, stored, q, far);
+    const __m256i merged = _mm256_blendv_epi8(stored, kEqual ? far : q, pass);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(io),
+                     _mm_packus_epi32(_mm256_castsi256_si128(merged),
+                                      _mm256_extracti128_si256(merged, 1)));
+    if (count < 8) std::memcpy(row, tail, count * sizeof(uint16_t));
+    return pass;
+  } else {
+    float* row = static_cast<float*>(span.depth) + x0;
+    const __m256 stored = _mm256_maskload_ps(row, inSpan);
+    const __m256 far = _mm256_set1_ps(1.0f);
+    __m256 pass;
+    if constexpr (kEqual) {
+      pass = _mm256_and_ps(
+          _mm256_and_ps(_mm256_castsi256_ps(inSpan),
+                        _mm256_cmp_ps(depth, stored, _CMP_EQ_OQ)),
+          _mm256_cmp_ps(stored, far, _CMP_NEQ_UQ));
+    } else {
+      // !(depth >= stored), как в скалярном ядре (с NaN тоже).
+      pass = _mm256_and_ps(_mm256_castsi256_ps(inSpan),
+                           _mm256_cmp_ps(depth, stored, _CMP_NGE_UQ));
+    }
+    _mm256_maskstore_ps(row, _mm256_castps_si256(pass), kEqual ? far : depth);
+    return _mm256_castps_si256(pass);
+  }
+}
+
+// Сколько дорожек в маске.
+__attribute__((target("avx2"))) inline int passCount(__m256i pass) {
+  return __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(pass)));
+}
+
+// Плоскости атрибутов треугольника, размноженные на 8 дорожек.
+struct ShadeAvx2 {
+  PlaneAvx2 normal[3];
+  PlaneAvx2 world[3];
+  PlaneAvx2 lit[3];
+  PlaneAvx2 invW;
+  PlaneAvx2 uvw[2];
+};
+
+template <LightingModel kLighting>
+__attribute__((target("avx2"))) inline ShadeAvx2 loadShade(
+    const SpanSetup& s) {
+  ShadeAvx2 c;
+  for (int k = 0; k < 3; k++) {
+    if constexpr (kLighting == LightingModel::Phong) {
+      c.normal[k] = loadPlane(s.normal[k]);
+      c.world[k] = loadPlane(s.world[k]);
+    } else {
+      c.lit[k] = loadPlane(s.lit[k]);
+    }
+  }
+  c.invW = loadPlane(s.invW);
+  c.uvw[0] = loadPlane(s.uvw[0]);
+  c.uvw[1] = loadPlane(s.uvw[1]);
+  return c;
+}
+
+// Освещённый цвет восьми пикселей по каналам — то же, что litColor().
+template <LightingModel kLighting>
+__attribute__((target("avx2"))) inline void litColorAvx2(
+    const SpanSetup& s, const ShadeAvx2& a, __m256 b1, __m256 b2,
+    __m256 color[3]) {
+  if constexpr (kLighting == LightingModel::Gouraud) {
+    for (int c = 0; c < 3; c++) color[c] = planeAt(a.lit[c], b1, b2);
+  } else if constexpr (kLighting == LightingModel::Flat) {
+    for (int c = 0; c < 3; c++) color[c] = _mm256_set1_ps(s.lit[c][0]);
+  } else {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 c255 = _mm256_set1_ps(255.0f);
+    const __m256 nx = planeAt(a.normal[0], b1, b2);
+    const __m256 ny = planeAt(a.normal[1], b1, b2);
+    const __m256 nz = planeAt(a.normal[2], b1, b2);
+    __m256 lx = _mm256_sub_ps(_mm256_set1_ps(s.lightPosition[0]),
+                              planeAt(a.world[0], b1, b2));
+    __m256 ly = _mm256_sub_ps(_mm256_set1_ps(s.lightPosition[1]),
+                              planeAt(a.world[1], b1, b2));
+    __m256 lz = _mm256_sub_ps(_mm256_set1_ps(s.lightPosition[2]),
+                              planeAt(a.world[2], b1, b2));
+    const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)),
+        _mm256_mul_ps(lz, lz)));
+    const __m256 positive = _mm256_cmp_ps(length, zero, _CMP_GT_OQ);
+    lx = _mm256_blendv_ps(lx, _mm256_div_ps(lx, length), positive);
+    ly = _mm256_blendv_ps(ly, _mm256_div_ps(ly, length), positive);
+    lz = _mm256_blendv_ps(lz, _mm256_div_ps(lz, length), positive);
+    // max_ps(0, x) == std::max(x, 0.0f),
+    // min_ps(255, x) == std::min(x, 255.0f).
+    const __m256 cosine = _mm256_max_ps(
+        zero, _mm256_add_ps(
+                  _mm256_add_ps(_mm256_mul_ps(nx, lx), _mm256_mul_ps(ny, ly)),
+                  _mm256_mul_ps(nz, lz)));
+
+    for (int c = 0; c < 3; c++) {
+      const __m256 lit =
+          _mm256_add_ps(_mm256_set1_ps(s.ambient[c]),
+                        _mm256_mul_ps(_mm256_set1_ps(s.diffuse[c]), cosine));
+      color[c] = _mm256_max_ps(zero, _mm256_min_ps(c255, lit));
+    }
+  }
+}
+
+// Номера текселей (x, y) уровня шириной width.
+__attribute__((target("avx2"))) inline __m256i texelIndex(__m256i x,
+                                                          __m256i y,
+                                                          int width) {
+  return _mm256_add_epi32(_mm256_mullo_epi32(y, _mm256_set1_epi32(width)), x);
+}
+
+// Тексели по номерам index; читаются только дорожки pass.
+__attribute__((target("avx2"))) inline __m256i gatherTexel(
+    const uint32_t* texture, __m256i index, __m256i pass) {
+  return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(),
+                                     reinterpret_cast<const int*>(texture),
+                                     index, pass, sizeof(uint32_t));
+}
+
+// Тот же texelCoordFixed, что в скалярном ядре.
+__attribute__((target("avx2"))) inline __m256i texelCoordFixedAvx2(__m256 u,
+                                                                  int size) {
+  const __m256 max = _mm256_set1_ps(static_cast<float>(size - 1));
+  return _mm256_cvttps_epi32(_mm256_mul_ps(
+      _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(u, max), _mm256_setzero_ps()),
+                    max),
+      _mm256_set1_ps(256.0f)));
+}
+
+// Та же lerpTexel, что в скалярном ядре: каналы — 16-битные дорожки.
+__attribute__((target("avx2"))) inline __m256i lerpTexelAvx2(__m256i a,
+                                                             __m256i b,
+                                                             __m256i w) {
+  const __m256i mask = _mm256_set1_epi32(0x00FF00FF);
+  const __m256i iw = _mm256_sub_epi32(_mm256_set1_epi32(256), w);
+  const __m256i w16 = _mm256_or_si256(w, _mm256_slli_epi32(w, 16));
+  const __m256i iw16 = _mm256_or_si256(iw, _mm256_slli_epi32(iw, 16));
+  const __m256i rb = _mm256_srli_epi16(
+      _mm256_add_epi16(_mm256_mullo_epi16(_mm256_and_si256(a, mask), iw16),
+                       _mm256_mullo_epi16(_mm256_and_si256(b, mask), w16)),
+      8);
+  const __m256i ga = _mm256_andnot_si256(
+      mask,
+      _mm256_add_epi16(
+          _mm256_mullo_epi16(
+              _mm256_and_si256(_mm256_srli_epi32(a, 8), mask), iw16),
+          _mm256_mullo_epi16(
+              _mm256_and_si256(_mm256_srli_epi32(b, 8), mask), w16)));
+  return _mm256_or_si256(rb, ga);
+}
+
+// Та же sampleBilinear, что в скалярном ядре.
+__attribute__((target("avx2"))) inline __m256i sampleBilinearAvx2(
+    const uint32_t* texture, int width, int height, __m256 u, __m256 v,
+    __m256i pass) {
+  const __m256i fx = texelCoordFixedAvx2(u, width);
+  const __m256i fy = texelCoordFixedAvx2(v, height);
+  const __m256i fraction = _mm256_set1_epi32(0xFF);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i x0 = _mm256_srli_epi32(fx, 8);
+  const __m256i y0 = _mm256_srli_epi32(fy, 8);
+  const __m256i x1 = _mm256_min_epi32(_mm256_add_epi32(x0, one),
+                                      _mm256_set1_epi32(width - 1));
+  const __m256i y1 = _mm256_min_epi32(_mm256_add_epi32(y0, one),
+                                      _mm256_set1_epi32(height - 1));
+  const __m256i top = lerpTexelAvx2(
+      gatherTexel(texture, texelIndex(x0, y0, width), pass),
+      gatherTexel(texture, texelIndex(x1, y0, width), pass),
+      _mm256_and_si256(fx, fraction));
+  const __m256i bottom = lerpTexelAvx2(
+      gatherTexel(texture, texelIndex(x0, y1, width), pass),
+      gatherTexel(texture, texelIndex(x1, y1, width), pass),
+      _mm256_and_si256(fx, fraction));
+  return lerpTexelAvx2(top, bottom, _mm256_and_si256(fy, fraction));
+}
+
+// Та же sampleTexture, что в скалярном ядре.
+template <TextureFilter kFilter>
+__attribute__((target("avx2"))) inline __m256i sampleTextureAvx2(
+    const SpanSetup& s, __m256 u, __m256 v, __m256i pass) {
+  if constexpr (kFilter == TextureFilter::Nearest) {
+    const int maxX = s.textureWidth - 1;
+    const int maxY = s.textureHeight - 1;
+    const __m256i tx = truncClamp(
+        _mm256_mul_ps(u, _mm256_set1_ps(static_cast<float>(maxX))), 0, maxX);
+    const __m256i ty = truncClamp(
+        _mm256_mul_ps(v, _mm256_set1_ps(static_cast<float>(maxY))), 0, maxY);
+    return gatherTexel(s.texture, texelIndex(tx, ty, s.textureWidth), pass);
+  } else {
+    const __m256i texel = sampleBilinearAvx2(s.texture, s.textureWidth,
+                                             s.textureHeight, u, v, pass);
+    if constexpr (kFilter == TextureFilter::Trilinear) {
+      return lerpTexelAvx2(texel,
+                           sampleBilinearAvx2(s.coarseTexture, s.coarseWidth,
+                                              s.coarseHeight, u, v, pass),
+                           _mm256_set1_epi32(s.lodBlend));
+    }
+    return texel;
+  }
+}
+
+// Цвет ARGB32 восьми пикселей с весами b1, b2 — то же, что shadePixel().
+// Текстура читается только в дорожках pass.
+template <LightingModel kLighting, bool kTextured, TextureFilter kFilter>
+__attribute__((target("avx2"))) inline __m256i shadeAvx2(const SpanSetup& s,
+                                                         const ShadeAvx2& a,
+                                                         __m256 b1, __m256 b2,
+                                                         __m256i pass) {
+  __m256 color[3];
+  litColorAvx2<kLighting>(s, a, b1, b2, color);
+  __m256i rgb[3];
+  for (int c = 0; c < 3; c++) rgb[c] = truncClamp(color[c], 0, 255);
+
+  if constexpr (kTextured) {
+    const __m256 r =
+        _mm256_div_ps(_mm256_set1_ps(1.0f), planeAt(a.invW, b1, b2));
+    const __m256 u = _mm256_mul_ps(planeAt(a.uvw[0], b1, b2), r);
+    const __m256 v = _mm256_mul_ps(planeAt(a.uvw[1], b1, b2), r);
+    const __m256i texel = sampleTextureAvx2<kFilter>(s, u, v, pass);
+    const __m256i channel = _mm256_set1_epi32(0xFF);
+    const __m256i half = _mm256_set1_epi32(128);
+    for (int c = 0; c < 3; c++) {
+      // Оба множителя не больше 255: произведение влезает в 16 бит.
+      const __m256i x = _mm256_add_epi32(
+          _mm256_mullo_epi16(
+              rgb[c],
+              _mm256_and_si256(_mm256_srli_epi32(texel, 8 * c), channel)),
+          half);
+      rgb[c] = _mm256_srli_epi32(
+          _mm256_add_epi32(x, _mm256_srli_epi32(x, 8)), 8);
+    }
+  }
+
+  return _mm256_or_si256(
+      _mm256_or_si256(_mm256_set1_epi32(static_cast<int>(0xFF000000u)),
+                      _mm256_slli_epi32(rgb[0], 16)),
+      _mm256_or_si256(_mm256_slli_epi32(rgb[1], 8), rgb[2]));
+}
+}  // namespace
+
+namespace {
+// Ядро AVX2 с теми же параметрами, что spanScalar(): по 8 пикселей.
+template <SpanOp kOp, DepthFormat kFormat, LightingModel kLighting,
+          bool kTextured, TextureFilter kFilter>
+__attribute__((target("avx2"))) int spanAvx2(const SpanSetup& s,
+                                             const RowSpan& span) {
+  constexpr bool kShading = kOp == SpanOp::Shade || kOp == SpanOp::ShadeEqual;
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i xEnd = _mm256_set1_epi32(span.xEnd);
+  const __m256i xRef = _mm256_set1_epi32(span.xRef);
+  const __m256 b1Ref = _mm256_set1_ps(span.b1);
+  const __m256 b2Ref = _mm256_set1_ps(span.b2);
+  const __m256 db1dx = _mm256_set1_ps(s.db1dx);
+  const __m256 db2dx = _mm256_set1_ps(s.db2dx);
+  const __m256i triangle = _mm256_set1_epi32(static_cast<int>(span.triangle));
+  const PlaneAvx2 z = loadPlane(s.z);
+  ShadeAvx2 shade;
+  if constexpr (kShading) shade = loadShade<kLighting>(s);
+  int written = 0;
+
+  for (int x0 = span.xBegin; x0 < span.xEnd; x0 += 8) {
+    const __m256i xs = _mm256_add_epi32(_mm256_set1_epi32(x0), lanes);
+    const __m256i inSpan = _mm256_cmpgt_epi32(xEnd, xs);
+    const __m256 t = _mm256_cvtepi32_ps(_mm256_sub_epi32(xs, xRef));
+    const __m256 b1 = _mm256_add_ps(b1Ref, _mm256_mul_ps(t, db1dx));
+    const __m256 b2 = _mm256_add_ps(b2Ref, _mm256_mul_ps(t, db2dx));
+
+    const __m256i pass = depthTestAvx2<kFormat, kOp == SpanOp::ShadeEqual>(
+        span, x0, planeAt(z, b1, b2), inSpan);
+    if constexpr (kOp == SpanOp::Depth) {
+      written += passCount(pass);
+      continue;
+    }
+    if (_mm256_testz_si256(pass, pass)) continue;
+    written += passCount(pass);
+    if constexpr (kOp == SpanOp::Visibility) {
+      _mm256_maskstore_epi32(reinterpret_cast<int*>(span.triangles + x0),
+                             pass, triangle);
+      _mm256_maskstore_ps(span.weights[0] + x0, pass, b1);
+      _mm256_maskstore_ps(span.weights[1] + x0, pass, b2);
+    } else {
+      _mm256_maskstore_epi32(
+          reinterpret_cast<int*>(span.color + x0), pass,
+          shadeAvx2<kLighting, kTextured, kFilter>(s, shade, b1, b2, pass));
+    }
+  }
+  return written;
+}
+
+template <LightingModel kLighting, bool kTextured, TextureFilter kFilter>
+__attribute__((target("avx2"))) void shadePixelsAvx2With(const SpanSetup& s,
+                                                         const float* b1,
+                                                         const float* b2,
+                                                         uint32_t* color,
+                                                         int count) {
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const ShadeAvx2 shade = loadShade<kLighting>(s);
+  for (int i = 0; i < count; i += 8) {
+    const __m256i mask =
+        _mm256_cmpgt_epi32(_mm256_set1_epi32(count - i), lanes);
+    const __m256i argb = shadeAvx2<kLighting, kTextured, kFilter>(
+        s, shade, _mm256_maskload_ps(b1 + i, mask),
+        _mm256_maskload_ps(b2 + i, mask), mask);
+    _mm256_maskstore_epi32(reinterpret_cast<int*>(color + i), mask, argb);
+  }
+}
+
+struct Avx2Isa {
+  template <SpanOp kOp, DepthFormat kFormat, LightingModel kLighting,
+            bool kTextured, TextureFilter kFilter>
+  static constexpr ShadeSpanFn kSpan =
+      spanAvx2<kOp, kFormat, kLighting, kTextured, kFilter>;
+  template <LightingModel kLighting, bool kTextured, TextureFilter kFilter>
+  static constexpr ShadePixelsFn kPixels =
+      shadePixelsAvx2With<kLighting, kTextured, kFilter>;
+};
+}  // namespace
+
+int shadeSpanAvx2(const SpanSetup& s, const RowSpan& span) {
+  return runSpan<Avx2Isa>(SpanOp::Shade, s, span);
+}
+
+int shadeSpanEqualAvx2(const SpanSetup& s, const RowSpan& span) {
+  return runSpan<Avx2Isa>(SpanOp::ShadeEqual, s, span);
+}
+
+int writeDepthAvx2(const SpanSetup& s, const RowSpan& span) {
+  return runSpan<Avx2Isa>(SpanOp::Depth, s, span);
+}
+
+int writeVisibilityAvx2(const SpanSetup& s, const RowSpan& span) {
+  return runSpan<Avx2Isa>(SpanOp::Visibility, s, span);
+}
+
+void shadePixelsAvx2(const SpanSetup& s, const float* b1, const float* b2,
+                     uint32_t* color, int count) {
+  pixelsFor<Avx2Isa>(s.lighting, s.filter, s.texture != nullptr)(
+      s, b1, b2, color, count);
+}
+
+bool cpuHasAvx2() { return __builtin_cpu_supports("avx2"); }
+#endif
+
+SpanKernels bestSpanKernels(SpanOp op, DepthFormat format,
+                            LightingModel lighting, TextureFilter filter) {
+#ifdef S21_SPAN_AVX2
+  if (cpuHasAvx2()) return kernelsFor<Avx2Isa>({op, format, lighting, filter});
+#endif
+  return kernelsFor<ScalarIsa>({op, format, lighting, filter});
+}
+
+ShadePixelsFn bestShadePixels(LightingModel lighting, TextureFilter filter,
+                              bool textured) {
+#ifdef S21_SPAN_AVX2
+  if (cpuHasAvx2()) return pixelsFor<Avx2Isa>(lighting, filter, textured);
+#endif
+  return pixelsFor<ScalarIsa>(lighting, filter, textured);
+}
+}  // namespace s21
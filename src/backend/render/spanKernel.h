@@ -0,0 +1,204 @@
+#ifndef RENDER_SPAN_KERNEL_H
+#define RENDER_SPAN_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "backend/render/framebuffer.h"
+
+// AVX2-ядро собирается через target("avx2") и выбирается во время работы,
+// поэтому от флагов сборки не зависит — нужен только x86 и GCC/Clang.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define S21_SPAN_AVX2 1
+#endif
+
+namespace s21 {
+/**
+ * @enum LightingModel
+ * @brief Где считается диффузное освещение граней.
+ */
+enum class LightingModel : int {
+  Phong,    ///< В каждом пикселе по интерполированным нормали и позиции.
+  Gouraud,  ///< В вершинах; в пикселе интерполируется цвет.
+  Flat,     ///< Раз на грань; цвет грани постоянный.
+};
+
+/**
+ * @enum TextureFilter
+ * @brief Выборка из текстуры. Уровень mip-цепочки выбирается на треугольник
+ * по отношению его площадей в текселях и в пикселях.
+ */
+enum class TextureFilter : int {
+  Nearest,    ///< Ближайший тексель уровня 0, без mip-цепочки.
+  Bilinear,   ///< Четыре соседних текселя ближайшего уровня.
+  Trilinear,  ///< Билинейная выборка из двух соседних уровней и их смесь.
+};
+
+/**
+ * @struct SpanSetup
+ * @brief Константы треугольника для закраски его пикселей.
+ *
+ * Атрибут в пикселе — (a[0] + b1 * a[1]) + b2 * a[2], где b1 и b2 — веса
+ * вершин 1 и 2, a[0] — значение в вершине 0, a[1] и a[2] — разности с ней.
+ * Вдоль строки веса линейны: b(x) = b(xRef) + (x - xRef) * db/dx.
+ */
+struct SpanSetup {
+  float db1dx = 0.0f;  ///< Приращение веса вершины 1 на столбец.
+  float db2dx = 0.0f;  ///< Приращение веса вершины 2 на столбец.
+
+  float z[3] = {};          ///< Глубина NDC.
+  float normal[3][3] = {};  ///< Нормаль в координатах камеры, по компонентам.
+  float world[3][3] = {};   ///< Мировая позиция, по компонентам.
+  float invW[3] = {};       ///< 1/w — для перспективной коррекции.
+  float uvw[2][3] = {};     ///< uv/w, по компонентам.
+
+  float lightPosition[3] = {};  ///< Позиция источника света.
+  float ambient[3] = {};        ///< Фоновая составляющая (материал * свет).
+  float diffuse[3] = {};  ///< Диффузная составляющая (материал * свет).
+
+  /// Какие плоскости заполнены: normal и world (Phong) или lit.
+  LightingModel lighting = LightingModel::Phong;
+  /// Освещённый цвет [0, 255] по каналам: у Flat заполнен только lit[c][0].
+  float lit[3][3] = {};
+
+  /// Тексели RGBA8 (R в младшем байте) или null.
+  const uint32_t* texture = nullptr;
+  int textureWidth = 0;   ///< Ширина текстуры.
+  int textureHeight = 0;  ///< Высота текстуры.
+
+  /// Фильтр выборки; texture — выбранный для треугольника уровень.
+  TextureFilter filter = TextureFilter::Nearest;
+  /// Следующий, вдвое меньший уровень — только для Trilinear.
+  const uint32_t* coarseTexture = nullptr;
+  int coarseWidth = 0;   ///< Ширина уровня coarseTexture.
+  int coarseHeight = 0;  ///< Высота уровня coarseTexture.
+  int lodBlend = 0;      ///< Доля coarseTexture в смеси в 1/256, [0, 256].
+};
+
+/**
+ * @struct RowSpan
+ * @brief Покрытый треугольником отрезок строки плитки, столбцы [xBegin, xEnd).
+ *
+ * Столбцы считаются от начала строки плитки; xRef может лежать и вне её.
+ * Ядро закраски пишет color, ядро видимости — triangles и weights.
+ */
+struct RowSpan {
+  int xBegin = 0;   ///< Первый столбец.
+  int xEnd = 0;     ///< Столбец за последним.
+  int xRef = 0;     ///< Столбец, в котором заданы b1 и b2.
+  float b1 = 0.0f;  ///< Вес вершины 1 в столбце xRef.
+  float b2 = 0.0f;  ///< Вес вершины 2 в столбце xRef.
+  void* depth = nullptr;      ///< Строка глубины плитки в формате depthFormat.
+  uint32_t* color = nullptr;  ///< Строка цвета плитки, ARGB32.
+  DepthFormat depthFormat = DepthFormat::Float32;  ///< Формат глубины.
+
+  uint32_t* triangles = nullptr;  ///< Строка номеров треугольников плитки.
+  float* weights[2] = {};         ///< Строки весов вершин 1 и 2 плитки.
+  uint32_t triangle = 0;          ///< Номер этого треугольника.
+};
+
+/**
+ * @enum SpanOp
+ * @brief Что ядро отрезка делает с прошедшими тест глубины пикселями.
+ */
+enum class SpanOp {
+  Shade,       ///< Закраска: освещение, текстура и запись цвета.
+  Visibility,  ///< Буфер видимости: номер треугольника и веса вершин.
+  Depth,       ///< Предпроход: только запись глубины.
+  ShadeEqual,  ///< Закраска после предпрохода, тест на равенство глубины.
+};
+
+/**
+ * @brief Закрашивает отрезок строки: тест и запись глубины, интерполяция
+ * атрибутов, диффузное освещение, текстура и запись цвета.
+ * @return Сколько пикселей прошло тест глубины.
+ */
+using ShadeSpanFn = int (*)(const SpanSetup& setup, const RowSpan& span);
+
+/**
+ * @brief Закрашивает count пикселей с весами вершин b1[i], b2[i]: то же
+ * освещение и текстура, что в ShadeSpanFn, без теста глубины.
+ */
+using ShadePixelsFn = void (*)(const SpanSetup& setup, const float* b1,
+                               const float* b2, uint32_t* color, int count);
+
+/**
+ * @struct SpanKernels
+ * @brief Ядра одной операции, формата глубины и модели освещения, собранные
+ * под своё сочетание при компиляции: без текстуры и с ней.
+ *
+ * Выбираются один раз на объект; внутри ядра нет ветвлений по формату,
+ * освещению и текстуре. Для операций без закраски оба ядра одинаковы.
+ */
+struct SpanKernels {
+  ShadeSpanFn plain = nullptr;     ///< SpanSetup::texture == nullptr.
+  ShadeSpanFn textured = nullptr;  ///< С выборкой из SpanSetup::texture.
+};
+
+/**
+ * @brief Скалярное ядро: по пикселю за шаг, работает везде. Формат глубины,
+ * освещение и текстура выбираются на каждый вызов — для тестов и редких
+ * вызовов, рендер берёт специализированные ядра из bestSpanKernels().
+ */
+int shadeSpanScalar(const SpanSetup& setup, const RowSpan& span);
+
+/**
+ * @brief Скалярное ядро закраски после предпрохода глубины: тест на
+ * равенство глубине в буфере. Пиксель закрашивает первый треугольник с этой
+ * глубиной, в буфер вместо неё пишется значение очистки.
+ */
+int shadeSpanEqualScalar(const SpanSetup& setup, const RowSpan& span);
+
+/**
+ * @brief Ядро предпрохода (тип ShadeSpanFn): только тест и запись глубины.
+ * Из setup нужны только z и приращения весов.
+ */
+int writeDepthScalar(const SpanSetup& setup, const RowSpan& span);
+
+/**
+ * @brief Ядро буфера видимости (тип ShadeSpanFn): тест и запись глубины, в
+ * прошедшие пиксели — номер треугольника и веса вместо цвета. Из setup
+ * нужны только z и приращения весов.
+ */
+int writeVisibilityScalar(const SpanSetup& setup, const RowSpan& span);
+
+/** @brief Скалярная закраска пикселей по весам. */
+void shadePixelsScalar(const SpanSetup& setup, const float* b1,
+                       const float* b2, uint32_t* color, int count);
+
+#ifdef S21_SPAN_AVX2
+/**
+ * @brief AVX2-ядро: по 8 пикселей за шаг, глубина и цвет пишутся
+ * маскированной записью. Результат побайтно совпадает со скалярным ядром.
+ */
+int shadeSpanAvx2(const SpanSetup& setup, const RowSpan& span);
+
+/** @brief AVX2-ядро закраски на равенство, совпадает со скалярным. */
+int shadeSpanEqualAvx2(const SpanSetup& setup, const RowSpan& span);
+
+/** @brief AVX2-ядро предпрохода глубины, совпадает со скалярным. */
+int writeDepthAvx2(const SpanSetup& setup, const RowSpan& span);
+
+/** @brief AVX2-ядро буфера видимости, совпадает со скалярным. */
+int writeVisibilityAvx2(const SpanSetup& setup, const RowSpan& span);
+
+/** @brief AVX2-закраска пикселей по весам, совпадает со скалярной. */
+void shadePixelsAvx2(const SpanSetup& setup, const float* b1, const float* b2,
+                     uint32_t* color, int count);
+
+/** @brief Поддерживает ли процессор AVX2. */
+bool cpuHasAvx2();
+#endif
+
+/**
+ * @brief Самые быстрые на этом процессоре ядра операции op для буфера
+ * глубины формата format, освещения lighting и фильтра текстуры filter.
+ */
+SpanKernels bestSpanKernels(SpanOp op, DepthFormat format,
+                            LightingModel lighting, TextureFilter filter);
+
+/** @brief Самая быстрая закраска пикселей по весам. */
+ShadePixelsFn bestShadePixels(LightingModel lighting, TextureFilter filter,
+                              bool textured);
+}  // namespace s21
+#endif  // RENDER_SPAN_KERNEL_H
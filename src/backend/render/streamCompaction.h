@@ -0,0 +1,84 @@
+#ifndef RENDER_STREAM_COMPACTION_H
+#define RENDER_STREAM_COMPACTION_H
+
+#include <omp.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "backend/render/frameArena.h"
+
+namespace s21 {
+/**
+ * @brief Параллельное сжатие потока в два прохода без блокировок.
+ *
+ * Вход делится на непрерывные диапазоны по потокам. Первый проход считает,
+ * сколько элементов останется в каждом диапазоне; префиксная сумма даёт
+ * каждому потоку смещение записи; второй проход пишет уцелевшие элементы.
+ * Порядок входа сохраняется, так что результат не зависит от числа потоков.
+ * @param arena Арена кадра для счётчиков потоков.
+ * @param count Длина входа.
+ * @param countRange countRange(lo, hi) — сколько элементов [lo, hi) останется.
+ * @param scatterRange scatterRange(lo, hi, out) — записать уцелевшие элементы
+ * [lo, hi) по порядку, начиная с позиции out.
+ * @return Сколько элементов осталось.
+ */
+template <typename CountFn, typename ScatterFn>
+size_t compactRanges(FrameArena& arena, size_t count, CountFn&& countRange,
+                     ScatterFn&& scatterRange) {
+  const int maxThreads = omp_get_max_threads();
+  size_t* offsets = arena.allocate<size_t>(maxThreads + 1);
+  size_t total = 0;
+
+#pragma omp parallel num_threads(maxThreads)
+  {
+    const size_t t = omp_get_thread_num();
+    const size_t n = omp_get_num_threads();
+    const size_t lo = count * t / n;
+    const size_t hi = count * (t + 1) / n;
+
+    offsets[t + 1] = countRange(lo, hi);
+
+#pragma omp barrier
+#pragma omp single
+    {
+      offsets[0] = 0;
+      for (size_t k = 0; k < n; k++) offsets[k + 1] += offsets[k];
+      total = offsets[n];
+    }
+
+    scatterRange(lo, hi, offsets[t]);
+  }
+  return total;
+}
+
+/**
+ * @brief Копирует элементы input[i], для которых keep(i) истинно, в output
+ * по порядку (аналог std::copy_if, параллельный и детерминированный).
+ *
+ * Предикат считается один раз: его результат между проходами хранится в
+ * байтовой карте из арены. input и output не должны пересекаться.
+ * @return Сколько элементов записано в output.
+ */
+template <typename T, typename Keep>
+size_t compactIf(FrameArena& arena, const T* input, size_t count, T* output,
+                 Keep&& keep) {
+  uint8_t* flags = arena.allocate<uint8_t>(count);
+  return compactRanges(
+      arena, count,
+      [&](size_t lo, size_t hi) {
+        size_t kept = 0;
+        for (size_t i = lo; i < hi; i++) {
+          flags[i] = keep(i) ? 1 : 0;
+          kept += flags[i];
+        }
+        return kept;
+      },
+      [&](size_t lo, size_t hi, size_t out) {
+        for (size_t i = lo; i < hi; i++) {
+          if (flags[i]) output[out++] = input[i];
+        }
+      });
+}
+}  // namespace s21
+#endif  // RENDER_STREAM_COMPACTION_H
@@ -1,8 +1,53 @@
 #include "scene.h"
 
+#include <algorithm>
+#include <future>
+
+#include "backend/loaders/meshCache/MeshCache.h"
 #include "backend/loaders/objectLoader/ObjectLoader.h"
 
 namespace s21 {
+namespace {
+// Превью обновляется каждые столько готовых треугольников.
+constexpr uint32_t kPreviewStep = 256u << 10;
+
+// Меш с гранями source, материалы которых перенумерованы (from -> to), в
+// копии; остальные массивы смотрят в source, keepAlive держит его живым.
+// Сам source не меняется — его ещё может читать запись кеша.
+std::shared_ptr<const Mesh> remappedView(const Mesh &source,
+                                         std::shared_ptr<const void> keepAlive,
+                                         uint32_t from, uint32_t to) {
+  auto mesh = std::make_shared<Mesh>();
+  mesh->vertices_.adopt(source.vertices_.data(), source.vertices_.size(),
+                        keepAlive);
+  mesh->normals_.adopt(source.normals_.data(), source.normals_.size(),
+                       keepAlive);
+  mesh->uvCoordinates_.adopt(source.uvCoordinates_.data(),
+                             source.uvCoordinates_.size(), keepAlive);
+  mesh->facePlanes_.adopt(source.facePlanes_.data(), source.facePlanes_.size(),
+                          keepAlive);
+  mesh->faces_ = std::vector<Face>(source.faces_.begin(), source.faces_.end());
+  mesh->remapMaterials(from, to);
+  return mesh;
+}
+
+// Копирует [begin, end) записанного участка в превью, дорастив его до size;
+// недописанный промежуток заполняется нулями.
+template <typename T>
+void copyWritten(MappedVector<T>& preview, const MappedVector<T>& source,
+                 uint32_t begin, uint32_t end, uint32_t size) {
+  const size_t old = preview.size();
+  if (old < size) {
+    preview.resize(size);
+    std::fill(preview.begin() + old, preview.end(), T::Zero());
+  }
+  if (begin < end) {
+    std::copy(source.data() + begin, source.data() + end,
+              preview.data() + begin);
+  }
+}
+}  // namespace
+
 Scene::Scene() {
   Camera camera{};
   cameras.push_back(camera);
@@ -14,14 +59,259 @@ Scene::Scene() {
 
 void Scene::render() {}
 
+Scene::~Scene() {
+  cancelLoading();
+  // Сцена уходит: дожидаемся всех потоков загрузки, запись кеша бросаем.
+  for (LoaderThread &retired : retiredLoaders) {
+    retired.progress->cancel();
+    retired.thread.join();
+  }
+}
+
 void Scene::loadObject(std::string filepath) {
-  Mesh mesh;
-  ObjectLoader::loadObj(filepath, mesh, materialManager);
-  Object obj{mesh};
+  auto mesh = std::make_shared<Mesh>();
+  const uint32_t firstMaterial = materialManager.size();
+  std::vector<std::string> dependencies;
+  LoadProgress progress;
+  const uint64_t key =
+      loadMesh(filepath, *mesh, materialManager, progress, dependencies);
+  MeshCache::store(key, *mesh, materialManager, firstMaterial, dependencies);
+  Object obj{std::move(mesh)};
 
   addObject(obj);
 }
 
+uint64_t Scene::loadMesh(const std::string &filepath, Mesh &mesh,
+                         MaterialManager &materials, LoadProgress &progress,
+                         std::vector<std::string> &dependencies) {
+  // Хеш всего файла нужен только кешу: его считает отдельный поток вместе с
+  // первым проходом разбора и сразу проверяет кеш. Загрузчик ждёт решения
+  // лишь перед первой записью в меш и материалы, а при попадании бросает
+  // разбор. Меш из кеша читается в свой объект: отменённый загрузчик может
+  // очистить mesh, не дождавшись этого потока.
+  bool cached = false;
+  Mesh cachedMesh;
+  std::future<uint64_t> hashing = std::async(std::launch::async, [&] {
+    const uint64_t key = MeshCache::hashFile(filepath, &progress);
+    if (!progress.isCancelled() &&
+        MeshCache::load(key, cachedMesh, materials)) {
+      cached = true;
+      progress.superseded = true;
+    }
+    return key;
+  });
+  ObjectLoader::loadObj(filepath, mesh, materials, 0, &dependencies, &progress,
+                        [&] {
+                          hashing.wait();
+                          return !cached;
+                        });
+  const uint64_t key = hashing.get();
+  if (progress.isCancelled()) return 0;
+  if (cached) {
+    mesh = std::move(cachedMesh);
+    progress.facesBuilt.store(mesh.faces_.size());
+    // Плоскости граней обычно лежат в кеше; если их не записали — считаем.
+    if (mesh.facePlanes_.size() != mesh.faces_.size()) {
+      mesh.computeFacePlanes();
+    }
+    return 0;
+  }
+  mesh.computeFacePlanes();
+  return key;
+}
+
+void Scene::loadObjectAsync(std::string filepath) {
+  cancelLoading();
+
+  auto progress = std::make_shared<LoadProgress>();
+  progress->publishStep = kPreviewStep;
+
+  // Свой менеджер материалов: сценовый в это время читает рендер. Id
+  // занимаем с конца сценового, чтобы грани превью не ссылались на чужие
+  // материалы (до слияния они рисуются дефолтным).
+  auto result = std::make_shared<PendingObject>();
+  result->firstMaterial = materialManager.size();
+  result->materials.reserveIds(result->firstMaterial);
+  loadingObject = result;
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    loadProgress = progress;
+    loadError.clear();
+    pending.reset();
+  }
+  loading = true;
+
+  loader = std::thread([this, filepath, progress, result] {
+    std::string error;
+    uint64_t key = 0;
+    std::vector<std::string> dependencies;
+    MaterialManager cacheMaterials;
+    try {
+      key = loadMesh(filepath, result->mesh, result->materials, *progress,
+                     dependencies);
+      // Сами материалы заберёт commitLoadedObject — кешу нужна копия.
+      if (key) cacheMaterials = result->materials;
+    } catch (const std::exception &e) {
+      error = e.what();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(pendingMutex);
+      // Отменённая загрузка сцену больше не трогает: в ней уже может идти
+      // следующая.
+      if (!progress->isCancelled()) {
+        if (error.empty()) {
+          pending = result;
+        } else {
+          loadError = filepath + ": " + error;
+        }
+        loading = false;
+      }
+    }
+
+    // Объект уже отдан сцене, кеш пишется следом: меш до конца записи
+    // только читается (commitLoadedObject его не меняет).
+    if (error.empty()) {
+      MeshCache::store(key, result->mesh, cacheMaterials,
+                       result->firstMaterial, dependencies, progress.get());
+    }
+    progress->finished = true;
+  });
+}
+
+void Scene::cancelLoading() {
+  if (!loader.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    // Готовый объект не отменяем: его поток только дописывает кеш.
+    if (loading) loadProgress->cancel();
+    loading = false;
+  }
+  // Поток не ждём: отменённый сам выйдет по флагу, соединим его позже.
+  retiredLoaders.push_back({std::move(loader), loadProgress});
+  dropPreview();
+}
+
+void Scene::joinFinishedLoaders() {
+  auto finished = [](LoaderThread &retired) {
+    if (!retired.progress->finished) return false;
+    retired.thread.join();  // поток уже на выходе
+    return true;
+  };
+  retiredLoaders.erase(std::remove_if(retiredLoaders.begin(),
+                                      retiredLoaders.end(), finished),
+                       retiredLoaders.end());
+}
+
+LoadStatus Scene::getLoadStatus() const {
+  LoadStatus status;
+  std::lock_guard<std::mutex> lock(pendingMutex);
+  status.loading = loading;
+  status.error = loadError;
+  if (loadProgress) {
+    status.totalBytes = loadProgress->totalBytes.load();
+    status.fileBytes = loadProgress->fileBytes.load();
+    status.bytesParsed = loadProgress->bytesParsed.load();
+    status.facesBuilt = loadProgress->facesBuilt.load();
+  }
+  return status;
+}
+
+bool Scene::commitLoadedObject() {
+  joinFinishedLoaders();
+  std::shared_ptr<PendingObject> ready;
+  bool finished = false;
+  {
+    // Не ждём поток загрузки: не успели сейчас — заберём на следующем кадре.
+    std::unique_lock<std::mutex> lock(pendingMutex, std::try_to_lock);
+    if (!lock.owns_lock()) return false;
+    ready = std::move(pending);
+    finished = !loading;
+  }
+  if (!ready) {
+    if (!finished) return updatePreview();
+    // Загрузка закончилась ошибкой — превью больше не нужно.
+    if (loader.joinable()) {
+      retiredLoaders.push_back({std::move(loader), loadProgress});
+    }
+    bool hadPreview = previewIndex != kNoPreview;
+    dropPreview();
+    return hadPreview;
+  }
+  // Поток ещё может писать кеш — соединим его, когда закончит.
+  if (loader.joinable()) {
+    retiredLoaders.push_back({std::move(loader), loadProgress});
+  }
+
+  uint32_t firstMaterial =
+      materialManager.merge(std::move(ready->materials), ready->firstMaterial);
+  std::shared_ptr<const Mesh> mesh(ready, &ready->mesh);
+  if (firstMaterial != ready->firstMaterial) {
+    mesh = remappedView(ready->mesh, ready, ready->firstMaterial,
+                        firstMaterial);
+  }
+  if (previewIndex != kNoPreview) {
+    // Трансформацию, которую успели задать превью, сохраняем.
+    objects[previewIndex].setMesh(std::move(mesh));
+  } else {
+    Object obj{std::move(mesh)};
+    addObject(obj);
+  }
+  previewIndex = kNoPreview;
+  previewExtent = MeshExtent{};
+  previewMesh.reset();
+  loadingObject.reset();
+  return true;
+}
+
+bool Scene::updatePreview() {
+  if (!loadingObject) return false;
+  const MeshExtent extent = loadProgress->published();
+  if (extent.faces == previewExtent.faces) return false;
+
+  if (previewIndex == kNoPreview) {
+    previewMesh = std::make_shared<Mesh>();
+    Object obj{previewMesh};
+    addObject(obj);
+    previewIndex = objects.size() - 1;
+  }
+
+  // Массивы загрузчика размечены заранее и не переезжают: готовые префиксы
+  // вершин и граней показываем без копирования.
+  const Mesh &source = loadingObject->mesh;
+  Mesh &preview = *previewMesh;
+  preview.vertices_.adopt(source.vertices_.data(), extent.vertices,
+                          loadingObject);
+  preview.faces_.adopt(source.faces_.data(), extent.faces, loadingObject);
+  preview.computeFacePlanes(previewExtent.faces);
+
+  // У нормалей и UV между файловым и сгенерированным участками остаётся
+  // недописанный промежуток — копируем только новые записанные куски.
+  copyWritten(preview.normals_, source.normals_, previewExtent.normals,
+              extent.normals, extent.genNormals);
+  copyWritten(preview.normals_, source.normals_,
+              std::max(previewExtent.genNormals, extent.genNormalsBegin),
+              extent.genNormals, extent.genNormals);
+  copyWritten(preview.uvCoordinates_, source.uvCoordinates_, previewExtent.uvs,
+              extent.uvs, extent.genUvs);
+  copyWritten(preview.uvCoordinates_, source.uvCoordinates_,
+              std::max(previewExtent.genUvs, extent.genUvsBegin), extent.genUvs,
+              extent.genUvs);
+
+  previewExtent = extent;
+  return true;
+}
+
+void Scene::dropPreview() {
+  if (previewIndex != kNoPreview) {
+    objects.erase(objects.begin() + previewIndex);
+  }
+  previewIndex = kNoPreview;
+  previewExtent = MeshExtent{};
+  previewMesh.reset();
+  loadingObject.reset();
+}
+
 void Scene::addObject(Object& obj) { objects.push_back(obj); }
 
 std::vector<Object>& Scene::getObjects() { return objects; }
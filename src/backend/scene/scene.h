@@ -1,9 +1,15 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "backend/camera/camera.h"
+#include "backend/loaders/loadProgress.h"
 #include "backend/material_manager/material_manager.h"
 #include "backend/object/object.h"
 
@@ -19,6 +25,14 @@ class Scene {
    */
   Scene();
 
+  /**
+   * @brief Отменяет фоновую загрузку и дожидается её потока.
+   */
+  ~Scene();
+
+  Scene(const Scene &) = delete;
+  Scene &operator=(const Scene &) = delete;
+
  public:
   /**
    * @brief Выполняет рендеринг сцены.
@@ -32,6 +46,41 @@ class Scene {
    */
   void loadObject(std::string filepath);
 
+  /**
+   * @brief Загружает объект из файла в фоновом потоке.
+   *
+   * Предыдущая незавершённая загрузка отменяется. Сцена меняется только в
+   * commitLoadedObject(): сначала появляется объект-превью с уже готовой
+   * частью граней, по завершении его меш заменяется полным. Кеш меша поток
+   * пишет уже после этого.
+   * @param filepath Путь к файлу объекта.
+   */
+  void loadObjectAsync(std::string filepath);
+
+  /**
+   * @brief Отменяет фоновую загрузку (если идёт) и убирает её превью.
+   *
+   * Поток загрузки не ждёт: отменённый выходит сам, а соединяется потом, в
+   * commitLoadedObject(). Уже готовый объект не отменяется — его поток
+   * только дописывает кеш.
+   */
+  void cancelLoading();
+
+  /**
+   * @brief Возвращает снимок прогресса фоновой загрузки.
+   * @return Состояние загрузки.
+   */
+  LoadStatus getLoadStatus() const;
+
+  /**
+   * @brief Переносит в сцену результат фоновой загрузки: готовый объект или
+   * новую опубликованную часть превью.
+   *
+   * Вызывается между кадрами из потока рендера.
+   * @return true, если сцена изменилась.
+   */
+  bool commitLoadedObject();
+
   /**
    * @brief Обновляет материал объекта.
    */
@@ -74,12 +123,86 @@ class Scene {
    */
   const Material &getMaterial(uint32_t idMaterial) const;
 
+ private:
+  /**
+   * @struct PendingObject
+   * @brief Результат фоновой загрузки: меш и его собственные материалы
+   *        (id материалов — в своём менеджере, с 1).
+   */
+  struct PendingObject {
+    Mesh mesh;                  ///< Загруженный меш.
+    MaterialManager materials;  ///< Материалы, прочитанные при загрузке.
+    uint32_t firstMaterial = 1;  ///< Первый id материала этой загрузки.
+  };
+
+  /**
+   * @brief Показывает в превью новые опубликованные загрузчиком грани.
+   * @return true, если превью обновилось.
+   */
+  bool updatePreview();
+
+  /**
+   * @brief Убирает превью незавершённой загрузки из сцены.
+   */
+  void dropPreview();
+
+  /**
+   * @brief Соединяет потоки загрузки, которые закончили работу.
+   */
+  void joinFinishedLoaders();
+
+  /**
+   * @brief Загружает меш через кеш, а при промахе — разбором .obj, и
+   * считает плоскости граней для отсечения задних граней.
+   *
+   * Хеш файла для кеша считается одновременно с разбором; при попадании в
+   * кеш разбор бросается до первой записи в меш. Кеш здесь не пишется:
+   * готовый меш сначала отдают сцене, а потом сохраняют (MeshCache::store)
+   * с возвращённым ключом.
+   * @param filepath Путь к файлу .obj.
+   * @param mesh Меш для результата.
+   * @param materials Менеджер, в который добавляются материалы.
+   * @param progress Прогресс и флаг отмены.
+   * @param dependencies Сюда добавляются прочитанные .mtl и текстуры.
+   * @return Ключ кеша, если меш разобран из текста и его стоит сохранить;
+   * 0, если он из кеша или загрузку отменили.
+   */
+  static uint64_t loadMesh(const std::string &filepath, Mesh &mesh,
+                           MaterialManager &materials, LoadProgress &progress,
+                           std::vector<std::string> &dependencies);
+
  private:
   std::vector<Object> objects;  ///< Список объектов сцены.
   MaterialManager materialManager;  ///< Менеджер материалов сцены.
   std::vector<Camera> cameras;  ///< Список камер сцены.
   Camera *currentCamera;  ///< Указатель на текущую активную камеру.
   std::vector<Light> lights;  ///< Список источников света.
+
+  std::thread loader;  ///< Поток фоновой загрузки.
+
+  /**
+   * @struct LoaderThread
+   * @brief Поток загрузки, который сцена больше не ждёт: отменённый или
+   *        дописывающий кеш.
+   */
+  struct LoaderThread {
+    std::thread thread;                      ///< Сам поток.
+    std::shared_ptr<LoadProgress> progress;  ///< Его флаги отмены и конца.
+  };
+  std::vector<LoaderThread> retiredLoaders;  ///< Соединить, когда закончат.
+  std::shared_ptr<LoadProgress> loadProgress;  ///< Прогресс текущей загрузки.
+  std::atomic<bool> loading{false};  ///< Поток загрузки ещё работает.
+  mutable std::mutex pendingMutex;  ///< Защищает pending и loadError.
+  std::shared_ptr<PendingObject> pending;  ///< Готовый, но не добавленный.
+  std::string loadError;  ///< Ошибка последней загрузки.
+
+  std::shared_ptr<PendingObject> loadingObject;  ///< Что строит загрузчик.
+  size_t previewIndex = kNoPreview;  ///< Индекс превью в objects.
+  /** Меш превью — единственный, который меняется после добавления в сцену,
+   *  и только между кадрами (в commitLoadedObject). */
+  std::shared_ptr<Mesh> previewMesh;
+  MeshExtent previewExtent;  ///< Какая часть меша уже в превью.
+  static constexpr size_t kNoPreview = static_cast<size_t>(-1);
 };
 }  // namespace s21
 #endif  // SCENE_H
\ No newline at end of file
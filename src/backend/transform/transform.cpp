@@ -1,7 +1,25 @@
 #include "transform.h"
 
+#include <atomic>
+
 namespace s21 {
-Transform::Transform() { matrix4x4 = Eigen::Matrix4f::Identity(); }
+namespace {
+// Общий счётчик версий: номер, выданный одной трансформации, больше не
+// встретится ни у какой другой.
+std::atomic<uint64_t> nextVersion{1};
+}  // namespace
+
+Transform::Transform() {
+  matrix4x4 = Eigen::Matrix4f::Identity();
+  normalMatrix_ = Eigen::Matrix3f::Identity();
+}
+
+void Transform::touch(bool normalChanged) {
+  version_ = nextVersion.fetch_add(1, std::memory_order_relaxed);
+  if (normalChanged) {
+    normalMatrix_ = matrix4x4.block<3, 3>(0, 0).inverse().transpose();
+  }
+}
 
 void Transform::translate(float x, float y, float z) {
   Matrix4x4 translationMatrix = Eigen::Matrix4f::Identity();
@@ -10,6 +28,7 @@ void Transform::translate(float x, float y, float z) {
   translationMatrix(2, 3) = z;
 
   matrix4x4 = translationMatrix * matrix4x4;
+  touch(false);
 }
 
 void Transform::scale(float sx, float sy, float sz) {
@@ -19,6 +38,7 @@ void Transform::scale(float sx, float sy, float sz) {
   scaleMatrix(2, 2) = sz;
 
   matrix4x4 = matrix4x4 * scaleMatrix;
+  touch(true);
 }
 
 void Transform::rotate(const Eigen::Vector3f &axis) {
@@ -44,6 +64,7 @@ void Transform::rotate(const Eigen::Vector3f &axis) {
   Eigen::Matrix4f rotateMatrix = rotateZ * rotateY * rotateX;
 
   matrix4x4 = matrix4x4 * rotateMatrix;
+  touch(true);
 }
 
 Vertex Transform::apply(const Vertex &localVertex) const {
@@ -51,8 +72,26 @@ Vertex Transform::apply(const Vertex &localVertex) const {
 }
 
 Normal Transform::applyToNormal(const Normal &localNormal) const {
-  Eigen::Matrix3f normalMatrix =
-      matrix4x4.block<3, 3>(0, 0).inverse().transpose();
-  return (normalMatrix * localNormal).normalized();
+  return (normalMatrix_ * localNormal).normalized();
+}
+
+void Transform::apply(const Vertex *localVertexes, size_t count,
+                      Vertex *globalVertexes) const {
+  const Matrix4x4 matrix = matrix4x4;
+
+#pragma omp parallel for
+  for (long long i = 0; i < static_cast<long long>(count); i++) {
+    globalVertexes[i] = matrix * localVertexes[i];
+  }
+}
+
+void Transform::applyToNormals(const Normal *localNormals, size_t count,
+                               Normal *globalNormals) const {
+  const Eigen::Matrix3f matrix = normalMatrix_;
+
+#pragma omp parallel for
+  for (long long i = 0; i < static_cast<long long>(count); i++) {
+    globalNormals[i] = (matrix * localNormals[i]).normalized();
+  }
 }
 }  // namespace s21
\ No newline at end of file
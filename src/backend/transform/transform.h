@@ -1,6 +1,9 @@
 #ifndef TRANSFORM_H
 #define TRANSFORM_H
 
+#include <cstddef>
+#include <cstdint>
+
 #include "backend/types.h"
 
 namespace s21 {
@@ -17,8 +20,51 @@ class Transform {
 
   Normal applyToNormal(const Normal& localNormal) const;
 
+  /**
+   * @brief Переводит массив вершин одной матрицей (параллельно).
+   * @param localVertexes Исходные вершины.
+   * @param count Число вершин.
+   * @param globalVertexes Куда писать результат (count элементов).
+   */
+  void apply(const Vertex* localVertexes, size_t count,
+             Vertex* globalVertexes) const;
+
+  /**
+   * @brief Переводит массив нормалей закешированной матрицей нормалей.
+   * @param localNormals Исходные нормали.
+   * @param count Число нормалей.
+   * @param globalNormals Куда писать результат (count элементов).
+   */
+  void applyToNormals(const Normal* localNormals, size_t count,
+                      Normal* globalNormals) const;
+
+  /**
+   * @brief Матрица нормалей: обратная транспонированная к верхнему 3x3.
+   *
+   * Считается заново только после rotate/scale (перенос её не меняет), а не
+   * на каждую нормаль.
+   */
+  const Eigen::Matrix3f& normalMatrix() const { return normalMatrix_; }
+
+  /**
+   * @brief Версия трансформации: меняется при каждом translate/rotate/scale.
+   *
+   * Номера берутся из общего счётчика, поэтому у разных трансформаций они не
+   * совпадают (кроме 0 — единичной). Одинаковая версия значит одинаковую
+   * матрицу, и посчитанное по ней можно не пересчитывать.
+   */
+  uint64_t version() const { return version_; }
+
+  /** @brief Матрица трансформации (модели). */
+  const Matrix4x4& matrix() const { return matrix4x4; }
+
  private:
+  // Отмечает изменение матрицы; normalChanged — изменилось ли верхнее 3x3.
+  void touch(bool normalChanged);
+
   Matrix4x4 matrix4x4;
+  Eigen::Matrix3f normalMatrix_;  ///< Кеш матрицы нормалей.
+  uint64_t version_ = 0;          ///< См. version().
 };
 }  // namespace s21
-#endif  // TRANSFORM_H
\ No newline at end of file
+#endif  // TRANSFORM_H
@@ -2,6 +2,7 @@
 #define TYPES_H
 
 #include <Eigen/Dense>
+#include <cstdint>
 
 namespace s21 {
 /**
@@ -34,12 +35,25 @@ using Vector3F = Eigen::Vector3f;
  */
 using Color = Eigen::Vector3f;
 
+/**
+ * @typedef Texel
+ * @brief Тексель RGBA8, упакованный в 32 бита: R в младшем байте, A в
+ * старшем.
+ */
+using Texel = uint32_t;
+
 /**
  * @typedef UVCoordinate
  * @brief Определяет координаты текстурирования как 2-мерный вектор.
  */
 using UVCoordinate = Eigen::Vector2f;
 
+/**
+ * @typedef Plane
+ * @brief Плоскость (nx, ny, nz, d): точка p лежит на ней, если n·p + d = 0.
+ */
+using Plane = Eigen::Vector4f;
+
 /**
  * @typedef Matrix4x4
  * @brief Определяет 4x4 матрицу трансформаций.
@@ -0,0 +1,90 @@
+// Замер пропускной способности ObjectLoader в МБ/с.
+//
+//   ./build/loader_bench [model.obj] [повторов]
+//
+// Без аргументов генерирует во временной папке сетку ~100 МБ (v/vt/vn и
+// четырёхугольные грани v/vt/vn) и грузит её несколько раз — последовательно
+// и в 2, 4, ... потоков (OMP_NUM_THREADS ограничивает максимум).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <omp.h>
+
+#include "backend/loaders/objectLoader/ObjectLoader.h"
+
+using namespace s21;
+
+namespace {
+std::string generateGrid(int side) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "s21_loader_bench.obj";
+  std::ofstream out(path);
+  char buf[128];
+
+  for (int y = 0; y <= side; ++y) {
+    for (int x = 0; x <= side; ++x) {
+      std::snprintf(buf, sizeof(buf), "v %.6f %.6f %.6f\n", x * 0.01f,
+                    y * 0.01f, 0.001f * ((x * 7 + y * 13) % 100));
+      out << buf;
+      std::snprintf(buf, sizeof(buf), "vt %.6f %.6f\n", float(x) / side,
+                    float(y) / side);
+      out << buf;
+      out << "vn 0.000000 0.000000 1.000000\n";
+    }
+  }
+
+  const int row = side + 1;
+  for (int y = 0; y < side; ++y) {
+    for (int x = 0; x < side; ++x) {
+      int a = y * row + x + 1, b = a + 1, c = a + row + 1, d = a + row;
+      std::snprintf(buf, sizeof(buf), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                    a, a, a, b, b, b, c, c, c, d, d, d);
+      out << buf;
+    }
+  }
+  return path.string();
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string path = argc > 1 ? argv[1] : generateGrid(800);
+  int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+  double mb = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+
+  std::printf("%s: %.1f MB\n", path.c_str(), mb);
+
+  // Один поток — последовательный разбор; дальше удваиваем до максимума
+  // OpenMP, чтобы было видно масштабирование по ядрам.
+  const int maxThreads = omp_get_max_threads();
+  double serialRate = 0.0;
+  for (int threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+    double best = 0.0, total = 0.0;
+    size_t faces = 0;
+    for (int i = 0; i < runs; ++i) {
+      Mesh mesh;
+      MaterialManager materials;
+      auto start = std::chrono::steady_clock::now();
+      ObjectLoader::loadObj(path, mesh, materials, threads);
+      auto end = std::chrono::steady_clock::now();
+
+      double rate = mb / std::chrono::duration<double>(end - start).count();
+      best = std::max(best, rate);
+      total += rate;
+      faces = mesh.faces_.size();
+    }
+    if (threads == 1) serialRate = total / runs;
+
+    std::printf(
+        "loadObj x%-2d: avg %7.1f MB/s, best %7.1f MB/s, x%.2f (%zu triangles, "
+        "%d runs)\n",
+        threads, total / runs, best, total / runs / serialRate, faces, runs);
+    if (threads == maxThreads) break;
+  }
+  return 0;
+}
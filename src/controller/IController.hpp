@@ -3,6 +3,8 @@
 #include <QImage>
 #include <string>
 
+#include "backend/loaders/loadProgress.h"
+#include "backend/render/renderSettings.hpp"
 #include "backend/types.h"
 
 namespace s21 {
@@ -13,11 +15,22 @@ namespace s21 {
 class IController {
  public:
   /**
-   * @brief Загружает объект в сцену.
+   * @brief Запускает фоновую загрузку объекта в сцену.
    * @param filePath Путь к файлу объекта.
    */
   virtual void loadObject(const std::string& filePath) = 0;
 
+  /**
+   * @brief Отменяет фоновую загрузку объекта.
+   */
+  virtual void cancelLoading() = 0;
+
+  /**
+   * @brief Возвращает прогресс фоновой загрузки.
+   * @return Снимок состояния загрузки.
+   */
+  virtual LoadStatus getLoadStatus() = 0;
+
   /**
    * @brief Получает изображение сцены.
    * @return Изображение сцены в формате QImage.
@@ -50,8 +63,12 @@ class IController {
 
   /**
    * @brief Изменяет настройки рендеринга граней.
+   * @param lighting Где считается освещение: в пикселе, вершине или грани.
+   * @param filter Фильтр текстур: ближайший тексель или mip-уровни.
    */
-  virtual void changeRenderFaceSetting(bool enable, bool texture) = 0;
+  virtual void changeRenderFaceSetting(bool enable, bool texture,
+                                       LightingModel lighting,
+                                       TextureFilter filter) = 0;
 
   /**
    * @brief Перемещает сцену в пространстве.
@@ -15,6 +15,12 @@ class MockController : public IController {
    */
   void loadObject(const std::string&) override {}
 
+  /**
+   * @brief Заглушки фоновой загрузки.
+   */
+  void cancelLoading() override {}
+  LoadStatus getLoadStatus() override { return {}; }
+
   /**
    * @brief Возвращает тестовое изображение 100x100 пикселей.
    * @return QImage тестового размера.
@@ -26,11 +26,15 @@ void Controller::changeRenderLineSetting(bool enable, Color color,
   render->setSettings(settings);
 }
 
-void Controller::changeRenderFaceSetting(bool enable, bool texture) {
+void Controller::changeRenderFaceSetting(bool enable, bool texture,
+                                         LightingModel lighting,
+                                         TextureFilter filter) {
   RenderSettings settings = render->getSettings();
 
   settings.renderFace = enable;
   settings.texture = texture;
+  settings.lighting = lighting;
+  settings.textureFilter = filter;
   render->setSettings(settings);
 }
 
@@ -38,6 +42,7 @@ void Controller::updateModel() {
 #ifdef LOG_TIME
   auto start = std::chrono::high_resolution_clock::now();
 #endif
+  scene->commitLoadedObject();
   render->rendering(*scene);
 #ifdef LOG_TIME
   auto end = std::chrono::high_resolution_clock::now();
@@ -23,10 +23,24 @@ class Controller : public IController {
   Controller(Scene* scene, IRender* render) : scene(scene), render(render) {}
 
   /**
-   * @brief Загружает объект в сцену.
+   * @brief Запускает фоновую загрузку объекта; в сцену он попадёт в
+   * updateModel() между кадрами.
    * @param filePath Путь к файлу объекта.
    */
-  void loadObject(const std::string& filePath) { scene->loadObject(filePath); }
+  void loadObject(const std::string& filePath) {
+    scene->loadObjectAsync(filePath);
+  }
+
+  /**
+   * @brief Отменяет фоновую загрузку объекта.
+   */
+  void cancelLoading() { scene->cancelLoading(); }
+
+  /**
+   * @brief Возвращает прогресс фоновой загрузки.
+   * @return Снимок состояния загрузки.
+   */
+  LoadStatus getLoadStatus() { return scene->getLoadStatus(); }
 
   /**
    * @brief Получает изображение сцены.
@@ -35,7 +49,8 @@ class Controller : public IController {
   QImage getImage();
 
   /**
-   * @brief Обновляет модель сцены.
+   * @brief Добавляет в сцену загруженный в фоне объект (если готов) и
+   * рендерит кадр.
    */
   void updateModel();
 
@@ -65,8 +80,13 @@ class Controller : public IController {
 
   /**
    * @brief Изменяет настройки рендеринга граней.
+   * @param enable Рисовать ли грани.
+   * @param texture Накладывать ли текстуры.
+   * @param lighting Где считается освещение: в пикселе, вершине или грани.
+   * @param filter Фильтр текстур: ближайший тексель или mip-уровни.
    */
-  void changeRenderFaceSetting(bool enable, bool texture);
+  void changeRenderFaceSetting(bool enable, bool texture,
+                               LightingModel lighting, TextureFilter filter);
 
   /**
    * @brief Перемещает сцену в пространстве.
@@ -11,6 +11,9 @@ MainWidget::MainWidget(IController* controller, QWidget* parent)
     : QWidget(parent),
       viewer(nullptr),
       loadBtn(nullptr),
+      loadProgress(nullptr),
+      cancelLoadBtn(nullptr),
+      loadStatusLabel(nullptr),
       moveControl(nullptr),
       rotateControl(nullptr),
       scaleControl(nullptr),
@@ -46,6 +49,22 @@ void MainWidget::setupUi() {
   loadBtn = new FileLoadButton(settingsPanel);
   settingsLayout->addWidget(loadBtn);
 
+  QHBoxLayout* loadLayout = new QHBoxLayout();
+  loadProgress = new QProgressBar(settingsPanel);
+  loadProgress->setRange(0, 100);
+  cancelLoadBtn = new QPushButton(tr("Cancel"), settingsPanel);
+  loadLayout->addWidget(loadProgress);
+  loadLayout->addWidget(cancelLoadBtn);
+  settingsLayout->addLayout(loadLayout);
+
+  loadStatusLabel = new QLabel(settingsPanel);
+  loadStatusLabel->setWordWrap(true);
+  settingsLayout->addWidget(loadStatusLabel);
+
+  loadProgress->hide();
+  cancelLoadBtn->hide();
+  loadStatusLabel->hide();
+
   QGroupBox* transformGroup = new QGroupBox("Transform", settingsPanel);
   QVBoxLayout* transformLayout = new QVBoxLayout(transformGroup);
   moveControl = new ControlGroupWidget(
@@ -103,6 +122,10 @@ void MainWidget::setupConnections() {
           [this](const QString& filePath) {
             m_controller->loadObject(filePath.toStdString());
           });
+  connect(cancelLoadBtn, &QPushButton::clicked, this,
+          [this]() { m_controller->cancelLoading(); });
+  connect(viewer, &ViewerWidget::modelUpdated, this,
+          &MainWidget::updateLoadStatus);
 
   connect(pointSettingWidget, &PointSettingsWidget::pointSettingsChanged, this,
           [this](bool enabled, const QColor& color, int size, bool circulDot) {
@@ -119,8 +142,30 @@ void MainWidget::setupConnections() {
           });
 
   connect(faceSettingWidget, &FaceSettingsWidget::faceSettingsChanged, this,
-          [this](bool enable, bool texture) {
-            m_controller->changeRenderFaceSetting(enable, texture);
+          [this](bool enable, bool texture, LightingModel lighting,
+                 TextureFilter filter) {
+            m_controller->changeRenderFaceSetting(enable, texture, lighting,
+                                                  filter);
           });
 }
+
+void MainWidget::updateLoadStatus() {
+  LoadStatus status = m_controller->getLoadStatus();
+
+  loadProgress->setVisible(status.loading);
+  cancelLoadBtn->setVisible(status.loading);
+  if (status.loading) {
+    int percent = status.totalBytes
+                      ? static_cast<int>(100 * status.bytesParsed /
+                                         status.totalBytes)
+                      : 0;
+    loadProgress->setValue(percent);
+    loadStatusLabel->setText(QString("%1 MB, %2 faces")
+                                 .arg(status.fileBytesParsed() >> 20)
+                                 .arg(status.facesBuilt));
+  } else {
+    loadStatusLabel->setText(QString::fromStdString(status.error));
+  }
+  loadStatusLabel->setVisible(status.loading || !status.error.empty());
+}
 }  // namespace s21
\ No newline at end of file
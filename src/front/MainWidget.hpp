@@ -2,7 +2,10 @@
 #define MAIN_WIDGET_HPP
 
 #include <QKeyEvent>
+#include <QLabel>
 #include <QObject>
+#include <QProgressBar>
+#include <QPushButton>
 #include <QWidget>
 
 #include "ViewerWidget.hpp"
@@ -35,6 +38,12 @@ class MainWidget : public QWidget {
    */
   void keyPressEvent(QKeyEvent* event) override;
 
+ private slots:
+  /**
+   * @brief Обновляет индикатор фоновой загрузки (вызывается каждый кадр).
+   */
+  void updateLoadStatus();
+
  private:
   /**
    * @brief Устанавливает пользовательский интерфейс.
@@ -49,6 +58,9 @@ class MainWidget : public QWidget {
  private:
   ViewerWidget* viewer;     ///< Виджет отображения сцены.
   FileLoadButton* loadBtn;  ///< Кнопка загрузки файла.
+  QProgressBar* loadProgress;  ///< Прогресс фоновой загрузки.
+  QPushButton* cancelLoadBtn;  ///< Кнопка отмены загрузки.
+  QLabel* loadStatusLabel;     ///< Объём прочитанного или ошибка загрузки.
   ControlGroupWidget*
       moveControl;  ///< Группа элементов управления перемещением.
   ControlGroupWidget*
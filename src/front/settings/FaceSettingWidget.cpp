@@ -1,5 +1,6 @@
 #include "FaceSettingWidget.hpp"
 
+#include <QLabel>
 #include <QPushButton>
 #include <QVBoxLayout>
 
@@ -15,14 +16,36 @@ FaceSettingsWidget::FaceSettingsWidget(QWidget* parent) {
   texturesCheckbox->setChecked(true);
   layout->addWidget(texturesCheckbox);
 
+  // Пункты — в порядке LightingModel.
+  QLabel* lightingLabel = new QLabel("Lighting:", this);
+  lightingCombo = new QComboBox(this);
+  lightingCombo->addItems({"Phong (per pixel)", "Gouraud (per vertex)",
+                           "Flat (per face)"});
+  layout->addWidget(lightingLabel);
+  layout->addWidget(lightingCombo);
+
+  // Пункты — в порядке TextureFilter.
+  QLabel* filterLabel = new QLabel("Texture filter:", this);
+  filterCombo = new QComboBox(this);
+  filterCombo->addItems({"Nearest", "Bilinear (mipmaps)",
+                         "Trilinear (mipmaps)"});
+  layout->addWidget(filterLabel);
+  layout->addWidget(filterCombo);
+
   connect(enableCheckbox, &QCheckBox::toggled, this,
           &FaceSettingsWidget::updateFaceSettings);
   connect(texturesCheckbox, &QCheckBox::toggled, this,
           &FaceSettingsWidget::updateFaceSettings);
+  connect(lightingCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+          this, &FaceSettingsWidget::updateFaceSettings);
+  connect(filterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+          this, &FaceSettingsWidget::updateFaceSettings);
 }
 
 void FaceSettingsWidget::updateFaceSettings() {
-  emit faceSettingsChanged(enableCheckbox->isChecked(),
-                           texturesCheckbox->isChecked());
+  emit faceSettingsChanged(
+      enableCheckbox->isChecked(), texturesCheckbox->isChecked(),
+      static_cast<LightingModel>(lightingCombo->currentIndex()),
+      static_cast<TextureFilter>(filterCombo->currentIndex()));
 }
 }  // namespace s21
\ No newline at end of file
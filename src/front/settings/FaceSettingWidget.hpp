@@ -1,8 +1,11 @@
 #pragma once
 
 #include <QCheckBox>
+#include <QComboBox>
 #include <QWidget>
 
+#include "backend/render/renderSettings.hpp"
+
 namespace s21 {
 /**
  * @class FaceSettingsWidget
@@ -22,8 +25,11 @@ class FaceSettingsWidget : public QWidget {
    * @brief Сигнал, испускаемый при изменении настроек отображения граней.
    * @param enabled Включено ли отображение граней.
    * @param texturesEnabled Включены ли текстуры.
+   * @param lighting Модель освещения граней.
+   * @param filter Фильтр выборки из текстур.
    */
-  void faceSettingsChanged(bool enabled, bool texturesEnabled);
+  void faceSettingsChanged(bool enabled, bool texturesEnabled,
+                           LightingModel lighting, TextureFilter filter);
 
  private slots:
   /**
@@ -34,5 +40,7 @@ class FaceSettingsWidget : public QWidget {
  private:
   QCheckBox* enableCheckbox;  ///< Флажок включения отображения граней.
   QCheckBox* texturesCheckbox;  ///< Флажок включения текстур.
+  QComboBox* lightingCombo;     ///< Выбор модели освещения.
+  QComboBox* filterCombo;       ///< Выбор фильтра текстур.
 };
 }  // namespace s21
\ No newline at end of file
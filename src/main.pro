@@ -17,7 +17,9 @@ SOURCES += \
 
 #backend
 SOURCES += \
+        backend/loaders/mappedFile/MappedFile.cpp \
         backend/loaders/objectLoader/ObjectLoader.cpp \
+        backend/loaders/meshCache/MeshCache.cpp \
         backend/loaders/materialLoader/MaterialLoader.cpp \
         backend/loaders/textureLoader/TextureLoader.cpp \
         backend/material_manager/material_manager.cpp \
@@ -26,6 +28,8 @@ SOURCES += \
         backend/transform/transform.cpp \
         backend/scene/scene.cpp \
         backend/render/renderRasterize.cpp \
+        backend/render/spanKernel.cpp \
+        backend/render/framebuffer.cpp \
 
 #other
 SOURCES += \
@@ -68,7 +72,16 @@ QMAKE_LFLAGS_DEBUG +=  # Можно добавить флаги для отла
 
 # Переменные для тестов
 TEST_TARGET = test_binary
-TEST_SOURCES = tests/*.cpp backend/transform/transform.cpp
+TEST_SOURCES = tests/*.cpp backend/transform/transform.cpp \
+        backend/render/spanKernel.cpp \
+        backend/render/framebuffer.cpp \
+        backend/loaders/mappedFile/MappedFile.cpp \
+        backend/loaders/objectLoader/ObjectLoader.cpp \
+        backend/loaders/meshCache/MeshCache.cpp \
+        backend/loaders/materialLoader/MaterialLoader.cpp \
+        backend/loaders/textureLoader/TextureLoader.cpp \
+        backend/material_manager/material_manager.cpp \
+        backend/mesh/mesh.cpp
 TEST_LIBS = -lgtest -lgtest_main -pthread
 
 # Настройки сборки тестов
@@ -0,0 +1,411 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "../backend/loaders/meshCache/MeshCache.h"
+#include "../backend/loaders/objectLoader/ObjectLoader.h"
+#include "../backend/loaders/textureLoader/TextureLoader.h"
+using namespace s21;
+
+namespace {
+// Пишет текст во временный .obj и возвращает путь к нему.
+std::string writeObj(const std::string& name, const std::string& text) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / ("s21_" + name + ".obj");
+  std::ofstream(path) << text;
+  return path.string();
+}
+}  // namespace
+
+TEST(ObjectLoaderTest, MissingFileThrows) {
+  Mesh mesh;
+  MaterialManager materials;
+  EXPECT_THROW(ObjectLoader::loadObj("/nonexistent/s21.obj", mesh, materials),
+               std::runtime_error);
+}
+
+TEST(ObjectLoaderTest, QuadIsFanTriangulated) {
+  Mesh mesh;
+  MaterialManager materials;
+  ObjectLoader::loadObj(writeObj("quad",
+                                 "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+                                 "f 1 2 3 4\n"),
+                        mesh, materials);
+
+  ASSERT_EQ(mesh.vertices_.size(), 4u);
+  ASSERT_EQ(mesh.faces_.size(), 2u);
+  EXPECT_EQ(mesh.faces_[1].vertexIndex[0], 0u);
+  EXPECT_EQ(mesh.faces_[1].vertexIndex[1], 2u);
+  EXPECT_EQ(mesh.faces_[1].vertexIndex[2], 3u);
+  EXPECT_FLOAT_EQ(mesh.vertices_[2].w(), 1.0f);
+
+  // Нормалей и UV в файле нет: по одной сгенерированной на треугольник.
+  ASSERT_EQ(mesh.normals_.size(), 2u);
+  ASSERT_EQ(mesh.uvCoordinates_.size(), 2u);
+  EXPECT_FLOAT_EQ(mesh.normals_[0].z(), 1.0f);
+  EXPECT_EQ(mesh.faces_[1].normalIndex[2], 1u);
+  EXPECT_EQ(mesh.faces_[1].uvCoordinateIndex[0], 1u);
+}
+
+TEST(ObjectLoaderTest, FacePlanesFaceCounterClockwiseSide) {
+  Mesh mesh;
+  MaterialManager materials;
+  ObjectLoader::loadObj(writeObj("planes",
+                                 "v 0 0 2\nv 1 0 2\nv 1 1 2\nv 0 1 2\n"
+                                 "f 1 2 3 4\nf 1 1 2\n"),
+                        mesh, materials);
+  mesh.computeFacePlanes();
+
+  ASSERT_EQ(mesh.facePlanes_.size(), 3u);
+  EXPECT_TRUE(mesh.facePlanes_[0].isApprox(Plane(0, 0, 1, -2)));
+  EXPECT_TRUE(mesh.facePlanes_[1].isApprox(Plane(0, 0, 1, -2)));
+  // Вырожденная грань: плоскость нулевая, перед ней не лежит ни одна точка.
+  EXPECT_TRUE(mesh.facePlanes_[2].isZero());
+  // Глаз над плоскостью видит грань, под ней — нет.
+  EXPECT_GT(mesh.facePlanes_[0].dot(Vertex(0, 0, 10, 1)), 0.0f);
+  EXPECT_LT(mesh.facePlanes_[0].dot(Vertex(0, 0, -10, 1)), 0.0f);
+}
+
+TEST(ObjectLoaderTest, RelativeIndicesAndAttributes) {
+  Mesh mesh;
+  MaterialManager materials;
+  ObjectLoader::loadObj(writeObj("relative",
+                                 "# comment\r\n"
+                                 "v 0 0 0\r\nv 1 0 0\r\nv 0 1 0\r\n"
+                                 "vt 0.25 0.5\r\nvt 1 0\r\nvt 0 1\r\n"
+                                 "vn 0 0 -1\r\n"
+                                 "f -3/-3/-1 -2/-2/-1 -1/-1/-1\r\n"),
+                        mesh, materials);
+
+  ASSERT_EQ(mesh.faces_.size(), 1u);
+  const Face& face = mesh.faces_[0];
+  for (int k = 0; k < 3; ++k) {
+    EXPECT_EQ(face.vertexIndex[k], static_cast<uint32_t>(k));
+    EXPECT_EQ(face.uvCoordinateIndex[k], static_cast<uint32_t>(k));
+    EXPECT_EQ(face.normalIndex[k], 0u);
+  }
+  EXPECT_EQ(mesh.normals_.size(), 1u);
+  EXPECT_EQ(mesh.uvCoordinates_.size(), 3u);
+  EXPECT_FLOAT_EQ(mesh.uvCoordinates_[0].x(), 0.25f);
+  EXPECT_FLOAT_EQ(mesh.normals_[0].z(), -1.0f);
+}
+
+TEST(ObjectLoaderTest, GeneratedAttributesAreNotIndexed) {
+  // У первой грани нет ни vn, ни vt — нормаль и UV для неё генерируются.
+  // Индексы OBJ считаются только по элементам из файла, поэтому и -1, и 1 у
+  // второй грани — это единственные vn/vt файла, а не сгенерированные.
+  Mesh mesh;
+  MaterialManager materials;
+  ObjectLoader::loadObj(writeObj("generated_index",
+                                 "v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+                                 "vn 1 0 0\nvt 0.5 0.25\n"
+                                 "f 1 2 3\n"
+                                 "f 1/-1/-1 2/-1/-1 3/1/1\n"),
+                        mesh, materials);
+
+  ASSERT_EQ(mesh.faces_.size(), 2u);
+  const Face& face = mesh.faces_[1];
+  for (int k = 0; k < 3; ++k) {
+    const Normal& normal = mesh.normals_[face.normalIndex[k]];
+    EXPECT_FLOAT_EQ(normal.x(), 1.0f);
+    EXPECT_FLOAT_EQ(normal.z(), 0.0f);
+    const UVCoordinate& uv = mesh.uvCoordinates_[face.uvCoordinateIndex[k]];
+    EXPECT_FLOAT_EQ(uv.x(), 0.5f);
+    EXPECT_FLOAT_EQ(uv.y(), 0.25f);
+  }
+  EXPECT_FLOAT_EQ(mesh.normals_[mesh.faces_[0].normalIndex[0]].z(), 1.0f);
+  EXPECT_FLOAT_EQ(
+      mesh.uvCoordinates_[mesh.faces_[0].uvCoordinateIndex[0]].x(), 0.0f);
+}
+
+TEST(ObjectLoaderTest, BrokenVertexIndexSkipsTriangle) {
+  Mesh mesh;
+  MaterialManager materials;
+  ObjectLoader::loadObj(writeObj("broken",
+                                 "v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+                                 "f 1 2 7\nf 1//1 2 3\n"),
+                        mesh, materials);
+
+  ASSERT_EQ(mesh.faces_.size(), 1u);
+  EXPECT_EQ(mesh.normals_.size(), 1u);
+  EXPECT_EQ(mesh.faces_[0].normalIndex[0], 0u);
+}
+
+TEST(ObjectLoaderTest, ParallelMatchesSerialBytewise) {
+  // Группы с локальными v/vt/vn, относительные индексы, смена материала и
+  // грани без нормалей — всё, что склеивается на границах кусков.
+  std::string text = "mtllib missing.mtl\n";
+  for (int g = 0; g < 64; ++g) {
+    text += "o part" + std::to_string(g) + "\n";
+    if (g % 3 == 0) text += "usemtl __default__\n";
+    text += "v 0 0 " + std::to_string(g) + "\nv 1 0 0\nv 1 1 0\nv 0 1 0\n";
+    text += "vt 0 0\nvt 1 1\n";
+    if (g % 2) text += "vn 0 0 1\n";
+    text += (g % 2) ? "f -4/-2/-1 -3/-1/-1 -2/-1/-1 -1/-2/-1\n"
+                    : "f -4/-2 -3/-1 -2/-1\nf 1 -1 -2\n";
+  }
+  std::string path = writeObj("chunks", text);
+
+  Mesh serial, parallel;
+  MaterialManager serialMaterials, parallelMaterials;
+  ObjectLoader::loadObj(path, serial, serialMaterials, 1);
+  ObjectLoader::loadObj(path, parallel, parallelMaterials, 7);
+
+  auto sameBytes = [](const auto& a, const auto& b) {
+    using T = typename std::decay_t<decltype(a)>::value_type;
+    return a.size() == b.size() &&
+           std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+  };
+  ASSERT_GT(serial.faces_.size(), 64u);
+  EXPECT_TRUE(sameBytes(serial.vertices_, parallel.vertices_));
+  EXPECT_TRUE(sameBytes(serial.normals_, parallel.normals_));
+  EXPECT_TRUE(sameBytes(serial.uvCoordinates_, parallel.uvCoordinates_));
+  EXPECT_TRUE(sameBytes(serial.faces_, parallel.faces_));
+}
+
+TEST(ObjectLoaderTest, ProgressIsReportedAndCancelStops) {
+  // Несколько мегабайт, чтобы загрузчик успел отчитаться и проверить отмену.
+  std::string text;
+  for (int i = 0; i < 60000; ++i) {
+    text += "v 0.125 0.250 " + std::to_string(i) + "\nv 1 0 0\nv 0 1 0\n";
+    text += "f -3 -2 -1\n";
+  }
+  std::string path = writeObj("progress", text);
+
+  for (int threads : {1, 4}) {
+    Mesh mesh;
+    MaterialManager materials;
+    LoadProgress progress;
+    ObjectLoader::loadObj(path, mesh, materials, threads, nullptr, &progress);
+    EXPECT_EQ(progress.bytesParsed.load(), progress.totalBytes.load());
+    EXPECT_EQ(progress.facesBuilt.load(), mesh.faces_.size());
+    EXPECT_EQ(mesh.faces_.size(), 60000u);
+    // Проходы параллельного разбора в интерфейсе — байты самого файла.
+    LoadStatus status;
+    status.totalBytes = progress.totalBytes.load();
+    status.fileBytes = progress.fileBytes.load();
+    status.bytesParsed = progress.bytesParsed.load();
+    EXPECT_EQ(status.fileBytesParsed(), text.size());
+
+    Mesh cancelled;
+    LoadProgress cancel;
+    cancel.cancel();
+    ObjectLoader::loadObj(path, cancelled, materials, threads, nullptr,
+                          &cancel);
+    EXPECT_TRUE(cancelled.faces_.empty());
+    EXPECT_LT(cancel.bytesParsed.load(), cancel.totalBytes.load());
+  }
+}
+
+TEST(ObjectLoaderTest, PublishedPrefixIsSelfContained) {
+  // Группы перемежают v/vn и грани, половина граней без vn — у нормалей
+  // появляются оба участка, файловый и сгенерированный.
+  std::string text;
+  for (int g = 0; g < 200; ++g) {
+    text += "v 0 0 " + std::to_string(g) + "\nv 1 0 0\nv 1 1 0\nv 0 1 0\n";
+    if (g % 2) text += "vn 0 0 1\nf -4//-1 -3//-1 -2//-1 -1//-1\n";
+    else text += "f -4 -3 -2 -1\n";
+  }
+  std::string path = writeObj("publish", text);
+
+  for (int threads : {1, 3}) {
+    Mesh mesh;
+    MaterialManager materials;
+    LoadProgress progress;
+    progress.publishStep = 50;
+    ObjectLoader::loadObj(path, mesh, materials, threads, nullptr, &progress);
+
+    const MeshExtent extent = progress.published();
+    ASSERT_GT(extent.faces, 0u);
+    // Куски публикуются по порядку, поэтому к концу виден весь меш.
+    ASSERT_EQ(extent.faces, mesh.faces_.size());
+    for (uint32_t i = 0; i < extent.faces; ++i) {
+      const Face& face = mesh.faces_[i];
+      for (int k = 0; k < 3; ++k) {
+        uint32_t n = face.normalIndex[k];
+        EXPECT_LT(face.vertexIndex[k], extent.vertices);
+        EXPECT_TRUE(n < extent.normals ||
+                    (n >= extent.genNormalsBegin && n < extent.genNormals));
+      }
+    }
+  }
+}
+
+TEST(ObjectLoaderTest, BeforeWriteCanDropParse) {
+  std::string text;
+  for (int i = 0; i < 100; ++i) text += "v 0 0 0\nv 1 0 0\nv 0 1 0\n";
+  text += "mtllib s21_missing.mtl\nf 1 2 3\n";
+  std::string path = writeObj("before_write", text);
+
+  for (int threads : {1, 3}) {
+    Mesh mesh;
+    MaterialManager materials;
+    std::vector<std::string> dependencies;
+    int calls = 0;
+    ObjectLoader::loadObj(path, mesh, materials, threads, &dependencies,
+                          nullptr, [&] { return ++calls, false; });
+    EXPECT_EQ(calls, 1);
+    EXPECT_TRUE(mesh.vertices_.empty());
+    EXPECT_TRUE(mesh.faces_.empty());
+    EXPECT_TRUE(dependencies.empty());
+  }
+}
+
+namespace {
+// Кеш в отдельном временном каталоге, чтобы тесты не трогали ~/.cache.
+std::filesystem::path useTempCache() {
+  std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "s21_mesh_cache_test";
+  std::filesystem::remove_all(dir);
+  setenv("S21_CACHE_DIR", dir.c_str(), 1);
+  return dir;
+}
+
+const char* kCachedObj =
+    "mtllib s21_cache.mtl\nv 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+    "vt 0 0\nvt 1 1\nusemtl red\nf 1/1 2/2 3/1 4/2\n";
+}  // namespace
+
+TEST(MeshCacheTest, RoundTripIsZeroCopyAndRemapsMaterials) {
+  useTempCache();
+  std::string path = writeObj("cache", kCachedObj);
+  std::ofstream(std::filesystem::path(path).parent_path() / "s21_cache.mtl")
+      << "newmtl red\nKd 1 0 0\n";
+
+  Mesh parsed;
+  MaterialManager parsedMaterials;
+  std::vector<std::string> dependencies;
+  uint64_t key = MeshCache::hashFile(path);
+  ASSERT_FALSE(MeshCache::load(key, parsed, parsedMaterials));
+  ObjectLoader::loadObj(path, parsed, parsedMaterials, 0, &dependencies);
+  parsed.computeFacePlanes();
+  MeshCache::store(key, parsed, parsedMaterials, 1, dependencies);
+
+  // Во второй сцене уже есть чужой материал — id должны сдвинуться.
+  Mesh cached;
+  MaterialManager cachedMaterials;
+  std::string otherName = "other";
+  Material other;
+  cachedMaterials.addMaterial(otherName, other);
+  ASSERT_TRUE(MeshCache::load(key, cached, cachedMaterials));
+  EXPECT_TRUE(cached.vertices_.isMapped());
+  ASSERT_EQ(cached.faces_.size(), parsed.faces_.size());
+  EXPECT_EQ(std::memcmp(cached.vertices_.data(), parsed.vertices_.data(),
+                        parsed.vertices_.size() * sizeof(Vertex)),
+            0);
+  EXPECT_EQ(std::memcmp(cached.normals_.data(), parsed.normals_.data(),
+                        parsed.normals_.size() * sizeof(Normal)),
+            0);
+  // Плоскости граней не пересчитываются, а берутся из кеша.
+  EXPECT_TRUE(cached.facePlanes_.isMapped());
+  ASSERT_EQ(cached.facePlanes_.size(), parsed.faces_.size());
+  EXPECT_EQ(std::memcmp(cached.facePlanes_.data(), parsed.facePlanes_.data(),
+                        parsed.facePlanes_.size() * sizeof(Plane)),
+            0);
+  EXPECT_EQ(cached.faces_[0].materialIndex,
+            parsed.faces_[0].materialIndex + 1);
+  std::string red = "red";
+  EXPECT_EQ(cachedMaterials.getMaterialId(red), cached.faces_[0].materialIndex);
+  EXPECT_FLOAT_EQ(cachedMaterials.getMaterial(cached.faces_[0].materialIndex)
+                      .diffuse.x(),
+                  1.0f);
+}
+
+TEST(MeshCacheTest, StaleOrCorruptCacheIsIgnored) {
+  std::filesystem::path dir = useTempCache();
+  std::string path = writeObj("cache_stale", kCachedObj);
+  std::filesystem::path mtl =
+      std::filesystem::path(path).parent_path() / "s21_cache.mtl";
+  std::ofstream(mtl) << "newmtl red\nKd 1 0 0\n";
+
+  Mesh mesh;
+  MaterialManager materials;
+  std::vector<std::string> dependencies;
+  uint64_t key = MeshCache::hashFile(path);
+  ObjectLoader::loadObj(path, mesh, materials, 0, &dependencies);
+  MeshCache::store(key, mesh, materials, 1, dependencies);
+
+  // Изменился .mtl — кеш устарел.
+  std::ofstream(mtl) << "newmtl red\nKd 0 1 0\n";
+  Mesh stale;
+  MaterialManager staleMaterials;
+  EXPECT_FALSE(MeshCache::load(key, stale, staleMaterials));
+  EXPECT_EQ(staleMaterials.size(), 1u);
+  EXPECT_TRUE(stale.faces_.empty());
+
+  // Перезаписываем кеш и портим байт в массиве вершин.
+  dependencies.clear();
+  Mesh fresh;
+  MaterialManager freshMaterials;
+  ObjectLoader::loadObj(path, fresh, freshMaterials, 0, &dependencies);
+  MeshCache::store(key, fresh, freshMaterials, 1, dependencies);
+  std::filesystem::path cacheFile =
+      std::filesystem::directory_iterator(dir)->path();
+  {
+    std::fstream file(cacheFile,
+                      std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(-1, std::ios::end);
+    file.put('#');
+  }
+  Mesh corrupt;
+  MaterialManager corruptMaterials;
+  EXPECT_FALSE(MeshCache::load(key, corrupt, corruptMaterials));
+}
+
+TEST(MeshCacheTest, CancelledLoadNeitherHashesNorWrites) {
+  std::filesystem::path dir = useTempCache();
+  std::string path = writeObj("cache_cancel", kCachedObj);
+
+  Mesh mesh;
+  MaterialManager materials;
+  ObjectLoader::loadObj(path, mesh, materials, 0);
+  const uint64_t key = MeshCache::hashFile(path);
+  ASSERT_NE(key, 0u);
+
+  LoadProgress cancel;
+  cancel.cancel();
+  EXPECT_EQ(MeshCache::hashFile(path, &cancel), 0u);
+  MeshCache::store(key, mesh, materials, 1, {}, &cancel);
+  EXPECT_FALSE(std::filesystem::exists(dir) &&
+               !std::filesystem::is_empty(dir));
+
+  MeshCache::store(key, mesh, materials, 1, {});
+  Mesh cached;
+  MaterialManager cachedMaterials;
+  EXPECT_TRUE(MeshCache::load(key, cached, cachedMaterials));
+}
+
+TEST(TextureLoaderTest, MipChainAveragesBlocks) {
+  // Картинка 3x2 в формате PPM: следующий уровень 1x1 — среднее блока 2x2,
+  // третий столбец при нечётной ширине отбрасывается.
+  const unsigned char pixels[3 * 2 * 3] = {
+      0,  0,  0,   40, 80, 120, 255, 255, 255,   // строка 0
+      20, 60, 100, 60, 20, 20,  255, 255, 255};  // строка 1
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "s21_mip.ppm";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n3 2\n255\n";
+    file.write(reinterpret_cast<const char*>(pixels), sizeof(pixels));
+  }
+
+  Texture texture = TextureLoader::loadTexture(path.string());
+  ASSERT_EQ(texture.width_, 3);
+  ASSERT_EQ(texture.height_, 2);
+  EXPECT_EQ(texture.colors_.size(), Texture::mipTexels(3, 2));
+  EXPECT_EQ(Texture::mipTexels(3, 2), 7u);
+  ASSERT_EQ(texture.levels(), 2);
+
+  int width = 0, height = 0;
+  const Texel* base = texture.level(0, width, height);
+  EXPECT_EQ(base, texture.colors_.data());
+  // RGBA8: R в младшем байте, без альфы в файле A = 255.
+  EXPECT_EQ(base[4], 0xFF14143Cu);
+  const Texel* top = texture.level(1, width, height);
+  EXPECT_EQ(width, 1);
+  EXPECT_EQ(height, 1);
+  EXPECT_EQ(top, base + 6);
+  EXPECT_EQ(*top, 0xFF3C281Eu);
+}
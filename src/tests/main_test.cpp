@@ -70,4 +70,33 @@ TEST(TransformTest, ApplyToNormal) {
   EXPECT_FLOAT_EQ(result.x(), 0);
   EXPECT_FLOAT_EQ(result.y(), 1);
   EXPECT_FLOAT_EQ(result.z(), 0);
-}
\ No newline at end of file
+}
+TEST(TransformTest, NormalMatrixAndVersionTrackChanges) {
+  Transform transform;
+  EXPECT_EQ(transform.version(), 0u);
+  EXPECT_TRUE(transform.normalMatrix().isIdentity());
+
+  transform.translate(5, 0, 0);
+  uint64_t afterTranslate = transform.version();
+  EXPECT_NE(afterTranslate, 0u);
+  EXPECT_TRUE(transform.normalMatrix().isIdentity());
+
+  transform.scale(1, 2, 4);
+  EXPECT_NE(transform.version(), afterTranslate);
+  Transform other;
+  other.scale(1, 2, 4);
+  EXPECT_NE(other.version(), transform.version());
+
+  // Пакетный путь совпадает с поэлементным.
+  Normal normals[2] = {Normal(0, 1, 1), Normal(1, 0, 1)};
+  Normal batch[2];
+  transform.applyToNormals(normals, 2, batch);
+  for (int i = 0; i < 2; ++i) {
+    Normal single = transform.applyToNormal(normals[i]);
+    EXPECT_TRUE(batch[i].isApprox(single));
+  }
+  Vertex vertices[1] = {Vertex(1, 1, 1, 1)};
+  Vertex out[1];
+  transform.apply(vertices, 1, out);
+  EXPECT_EQ(out[0], transform.apply(vertices[0]));
+}
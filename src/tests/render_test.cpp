@@ -0,0 +1,792 @@
+#include <gtest/gtest.h>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "../backend/render/edgeFunction.h"
+#include "../backend/render/frameArena.h"
+#include "../backend/render/framebuffer.h"
+#include "../backend/render/polygonClipper.h"
+#include "../backend/render/spanKernel.h"
+#include "../backend/render/streamCompaction.h"
+using namespace s21;
+
+namespace {
+// Случайные параметры треугольника для сравнения ядер закраски между собой.
+// Без текстуры, если texture == nullptr; иначе за уровнем textureWidth x
+// textureHeight в texture лежит следующий уровень мипмапа.
+SpanSetup randomSetup(std::mt19937& rng, LightingModel lighting,
+                      TextureFilter filter, const uint32_t* texture,
+                      int textureWidth, int textureHeight) {
+  auto uniform = [&](float lo, float hi) {
+    return std::uniform_real_distribution<float>(lo, hi)(rng);
+  };
+  SpanSetup setup;
+  setup.lighting = lighting;
+  setup.filter = filter;
+  setup.db1dx = uniform(-0.05f, 0.05f);
+  setup.db2dx = uniform(-0.05f, 0.05f);
+  auto plane = [&](float* a, float lo, float hi) {
+    for (int k = 0; k < 3; ++k) a[k] = uniform(lo, hi);
+  };
+  plane(setup.z, -1.0f, 0.5f);
+  for (int c = 0; c < 3; ++c) {
+    plane(setup.normal[c], -1.0f, 1.0f);
+    plane(setup.world[c], -20.0f, 20.0f);
+    setup.lightPosition[c] = uniform(-50.0f, 50.0f);
+    setup.ambient[c] = uniform(0.0f, 60.0f);
+    setup.diffuse[c] = uniform(0.0f, 300.0f);
+    plane(setup.lit[c], 0.0f, 255.0f);
+  }
+  plane(setup.invW, 0.5f, 2.0f);
+  plane(setup.uvw[0], -0.2f, 1.2f);
+  plane(setup.uvw[1], -0.2f, 1.2f);
+  if (texture) {
+    setup.texture = texture;
+    setup.textureWidth = textureWidth;
+    setup.textureHeight = textureHeight;
+    setup.coarseTexture = texture + textureWidth * textureHeight;
+    setup.coarseWidth = std::max(1, textureWidth / 2);
+    setup.coarseHeight = std::max(1, textureHeight / 2);
+    setup.lodBlend = static_cast<int>(rng() % 257);
+  }
+  return setup;
+}
+}  // namespace
+
+TEST(FrameArenaTest, SteadyFramesDoNotAllocate) {
+  FrameArena arena;
+  for (int frame = 0; frame < 3; ++frame) {
+    arena.reset();
+    int* a = arena.allocate<int>(1000);
+    double* b = arena.allocate<double>(10);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 64, 0u);
+    a[999] = frame;
+    b[9] = frame;
+  }
+  // Первый кадр берёт добавочные блоки, второй reset сливает их в один блок.
+  EXPECT_EQ(arena.allocations(), 3u);
+  EXPECT_GE(arena.capacity(), 1000 * sizeof(int) + 10 * sizeof(double));
+
+  size_t before = arena.allocations();
+  arena.reset();
+  arena.allocate<int>(1000);
+  arena.reset();
+  EXPECT_EQ(arena.allocations(), before);
+}
+
+TEST(StreamCompactionTest, KeepsInputOrderForAnyThreadCount) {
+  std::vector<uint32_t> input(10007);
+  std::iota(input.begin(), input.end(), 0u);
+  auto keep = [&](size_t i) { return input[i] % 3 == 0 || input[i] % 7 == 1; };
+
+  std::vector<uint32_t> expected;
+  std::copy_if(input.begin(), input.end(), std::back_inserter(expected),
+               [](uint32_t x) { return x % 3 == 0 || x % 7 == 1; });
+
+  const int saved = omp_get_max_threads();
+  FrameArena arena;
+  for (int threads : {1, 3, 8}) {
+    omp_set_num_threads(threads);
+    arena.reset();
+    std::vector<uint32_t> output(input.size());
+    size_t kept =
+        compactIf(arena, input.data(), input.size(), output.data(), keep);
+    output.resize(kept);
+    EXPECT_EQ(output, expected) << threads << " threads";
+  }
+  omp_set_num_threads(saved);
+
+  arena.reset();
+  uint32_t none[1];
+  EXPECT_EQ(compactIf(arena, input.data(), 0, none, keep), 0u);
+}
+
+TEST(FramebufferTest, ClearResolveAndResizeReuseMemory) {
+  Framebuffer framebuffer(130, 70);
+  EXPECT_EQ(framebuffer.tilesX(), 3);
+  EXPECT_EQ(framebuffer.tilesY(), 2);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(framebuffer.colorTile(0)) % 64, 0u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(framebuffer.depthTile(0)) % 64, 0u);
+
+  framebuffer.clear(0xFF102030u);
+  framebuffer.prepareTile(5);
+  EXPECT_EQ(static_cast<float*>(framebuffer.depthTile(5))[0], 1.0f);
+  framebuffer.setPixel(0, 0, 1u);
+  framebuffer.setPixel(129, 69, 2u);
+  framebuffer.setPixel(64, 1, 3u);
+  framebuffer.setPixel(130, 0, 4u);  // за кадром — пропускается
+  framebuffer.setPixel(-1, 5, 4u);
+  // Плитка 1 (x 64..127, y 0..63), строка 1, столбец 0.
+  EXPECT_EQ(framebuffer.colorTile(1)[Framebuffer::kTileSize], 3u);
+
+  const int pitch = 131;  // строка изображения длиннее кадра
+  std::vector<uint32_t> image(pitch * 70, 0u);
+  framebuffer.resolve(reinterpret_cast<unsigned char*>(image.data()),
+                      pitch * sizeof(uint32_t));
+  for (int y = 0; y < 70; ++y) {
+    for (int x = 0; x < 130; ++x) {
+      uint32_t expected = 0xFF102030u;
+      if (x == 0 && y == 0) expected = 1u;
+      if (x == 129 && y == 69) expected = 2u;
+      if (x == 64 && y == 1) expected = 3u;
+      ASSERT_EQ(image[y * pitch + x], expected) << x << ", " << y;
+      ASSERT_EQ(framebuffer.pixel(x, y), expected) << x << ", " << y;
+    }
+    EXPECT_EQ(image[y * pitch + 130], 0u);
+  }
+
+  // Меньший кадр и формат с меньшими значениями в ту же память.
+  const size_t allocations = framebuffer.allocations();
+  framebuffer.resize(100, 40);
+  framebuffer.setDepthFormat(DepthFormat::Unorm16);
+  framebuffer.clear(0u);
+  framebuffer.prepareTile(1);
+  EXPECT_EQ(static_cast<uint16_t*>(framebuffer.depthTile(1))[7], 0xFFFFu);
+  framebuffer.setDepthFormat(DepthFormat::Unorm24);
+  framebuffer.clear(0u);
+  framebuffer.prepareTile(1);
+  EXPECT_EQ(static_cast<uint32_t*>(framebuffer.depthTile(1))[7], 0xFFFFFFu);
+  EXPECT_EQ(framebuffer.allocations(), allocations);
+  framebuffer.resize(300, 70);
+  EXPECT_GT(framebuffer.allocations(), allocations);
+}
+
+TEST(FramebufferTest, ClearIsLazyPerTile) {
+  Framebuffer framebuffer(128, 64);
+  framebuffer.clear(0xFF000001u);
+  framebuffer.setPixel(5, 5, 7u);
+  EXPECT_EQ(framebuffer.colorTile(0)[0], 0xFF000001u);
+
+  // Новый кадр памяти не касается: плитка 0 хранит прошлый кадр, но читается
+  // и выводится фоном, пока в неё не начнут писать.
+  framebuffer.clear(0xFF000002u);
+  EXPECT_EQ(framebuffer.colorTile(0)[5 * Framebuffer::kTileSize + 5], 7u);
+  EXPECT_EQ(framebuffer.pixel(5, 5), 0xFF000002u);
+
+  framebuffer.setPixel(70, 3, 9u);  // плитка 1
+  std::vector<uint32_t> image(128 * 64, 0u);
+  framebuffer.resolve(reinterpret_cast<unsigned char*>(image.data()),
+                      128 * sizeof(uint32_t));
+  for (int i = 0; i < 128 * 64; ++i) {
+    ASSERT_EQ(image[i], i == 3 * 128 + 70 ? 9u : 0xFF000002u) << i;
+  }
+
+  // Плитку готовят сразу несколько потоков — заливка одна, запись не теряется.
+  framebuffer.clear(0xFF000003u);
+#pragma omp parallel for num_threads(4)
+  for (int i = 0; i < 64; ++i) framebuffer.setPixel(i, i, 10u);
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_EQ(framebuffer.pixel(i, i), 10u);
+    EXPECT_EQ(framebuffer.pixel(63 - i, i), 0xFF000003u);
+  }
+}
+
+TEST(FramebufferTest, HiZBoundFollowsWrittenDepth) {
+  constexpr int kSize = Framebuffer::kTileSize;
+  Framebuffer framebuffer(kSize, kSize);
+  framebuffer.clear(0u);
+  framebuffer.prepareTile(0);
+  EXPECT_EQ(framebuffer.occludedBlocks(0, 0, 0, 7, 7, 0.9f), 0u);
+
+  // Блок 0 записан не весь — оценка остаётся дальней плоскостью.
+  float* depth = static_cast<float*>(framebuffer.depthTile(0));
+  uint64_t blocks = 0;
+  for (int y = 0; y < 8; ++y) {
+    std::fill_n(depth + y * kSize, 8, y == 7 ? 0.25f : 0.5f);
+    if (y < 7) blocks |= framebuffer.coverSpan(0, y, 0, 8);
+  }
+  EXPECT_EQ(blocks, 1u);
+  framebuffer.commitCoverage(0, blocks, 0.5f);
+  EXPECT_EQ(framebuffer.occludedBlocks(0, 0, 0, 0, 0, 0.9f), 0u);
+
+  // Записан целиком: оценка — самая дальняя глубина блока.
+  blocks = framebuffer.coverSpan(0, 7, 0, 8);
+  framebuffer.commitCoverage(0, blocks, 0.25f);
+  EXPECT_EQ(framebuffer.coveredPixels(), 64u);
+  EXPECT_EQ(framebuffer.occludedBlocks(0, 0, 0, 1, 1, 0.5f), 1u);
+  EXPECT_EQ(framebuffer.occludedBlocks(0, 0, 0, 1, 1, 0.4f), 0u);
+
+  // Новый кадр сбрасывает оценки.
+  framebuffer.clear(0u);
+  framebuffer.prepareTile(0);
+  EXPECT_EQ(framebuffer.occludedBlocks(0, 0, 0, 0, 0, 0.5f), 0u);
+}
+
+TEST(FramebufferTest, VisibilityBufferTracksTriangles) {
+  constexpr int kSize = Framebuffer::kTileSize;
+  Framebuffer framebuffer(kSize * 2, kSize);
+  EXPECT_FALSE(framebuffer.visibilityBuffer());
+  const size_t allocations = framebuffer.allocations();
+  framebuffer.setVisibilityBuffer(true);
+  EXPECT_EQ(framebuffer.allocations(), allocations + 2);
+
+  framebuffer.clear(0u);
+  framebuffer.prepareTile(1);
+  EXPECT_TRUE(framebuffer.isCleared(0));
+  const uint32_t* triangles = framebuffer.triangleTile(1);
+  EXPECT_TRUE(std::all_of(triangles, triangles + Framebuffer::kTilePixels,
+                          [](uint32_t id) {
+                            return id == Framebuffer::kNoTriangle;
+                          }));
+
+  // Точки и линии пишут цвет сразу: пиксель уходит из отложенной закраски.
+  framebuffer.triangleTile(1)[5 * kSize + 3] = 42u;
+  framebuffer.setPixel(kSize + 3, 5, 7u);
+  EXPECT_EQ(framebuffer.triangleTile(1)[5 * kSize + 3],
+            Framebuffer::kNoTriangle);
+
+  // Выключение не освобождает плоскости, повторное включение их не выделяет.
+  framebuffer.setVisibilityBuffer(false);
+  framebuffer.setVisibilityBuffer(true);
+  EXPECT_EQ(framebuffer.allocations(), allocations + 2);
+}
+
+#ifdef S21_SPAN_AVX2
+TEST(SpanKernelTest, Avx2MatchesScalarExactly) {
+  if (!cpuHasAvx2()) GTEST_SKIP() << "процессор без AVX2";
+
+  std::mt19937 rng(7);
+  auto uniform = [&](float lo, float hi) {
+    return std::uniform_real_distribution<float>(lo, hi)(rng);
+  };
+  // Две строки плитки: ядро не должно задевать вторую.
+  const int width = Framebuffer::kTileSize, rows = 2;
+  // Уровень 5x3 и следующий за ним 2x1.
+  std::vector<uint32_t> texture(5 * 3 + 2 * 1);
+  for (uint32_t& texel : texture) texel = rng();
+
+  for (int trial = 0; trial < 300; ++trial) {
+    const DepthFormat format = static_cast<DepthFormat>(trial % 3);
+    const SpanSetup setup = randomSetup(
+        rng, static_cast<LightingModel>(trial / 6 % 3),
+        static_cast<TextureFilter>(trial / 18 % 3),
+        trial % 2 ? texture.data() : nullptr, 5, 3);
+
+    // Часть глубины уже занята: маска теста глубины рваная.
+    const size_t depthBytes = Framebuffer::depthBytes(format);
+    std::vector<unsigned char> depth(width * rows * depthBytes);
+    for (size_t i = 0; i < depth.size(); i += depthBytes) {
+      const bool near = uniform(0.0f, 1.0f) < 0.3f;
+      if (format == DepthFormat::Float32) {
+        const float d = near ? 0.2f : 1.0f;
+        std::memcpy(&depth[i], &d, sizeof(d));
+      } else if (format == DepthFormat::Unorm24) {
+        const uint32_t d = near ? 0x999999u : 0xFFFFFFu;
+        std::memcpy(&depth[i], &d, sizeof(d));
+      } else {
+        const uint16_t d = near ? 0x9999u : 0xFFFFu;
+        std::memcpy(&depth[i], &d, sizeof(d));
+      }
+    }
+    std::vector<uint32_t> color(width * rows, 0xFFFFFFFFu);
+    const std::vector<unsigned char> before = depth;
+    std::vector<unsigned char> depthAvx = depth;
+    std::vector<uint32_t> colorAvx = color;
+
+    RowSpan span;
+    span.xRef = -3;
+    span.xBegin = trial % 13;
+    span.xEnd = width - trial % 7;
+    span.b1 = uniform(0.0f, 1.0f);
+    span.b2 = uniform(0.0f, 1.0f);
+    span.depthFormat = format;
+
+    span.depth = depth.data();
+    span.color = color.data();
+    const int written = shadeSpanScalar(setup, span);
+    span.depth = depthAvx.data();
+    span.color = colorAvx.data();
+    const int writtenAvx = shadeSpanAvx2(setup, span);
+
+    ASSERT_EQ(written, writtenAvx) << "trial " << trial;
+    ASSERT_EQ(depth, depthAvx) << "trial " << trial;
+    ASSERT_EQ(color, colorAvx) << "trial " << trial;
+    for (int x = width; x < width * rows; ++x) {
+      ASSERT_EQ(colorAvx[x], 0xFFFFFFFFu) << "trial " << trial;
+    }
+    ASSERT_TRUE(std::equal(before.begin() + width * depthBytes, before.end(),
+                           depthAvx.begin() + width * depthBytes))
+        << "trial " << trial;
+  }
+}
+
+TEST(SpanKernelTest, DeferredShadingMatchesForward) {
+  if (!cpuHasAvx2()) GTEST_SKIP() << "процессор без AVX2";
+
+  std::mt19937 rng(11);
+  auto uniform = [&](float lo, float hi) {
+    return std::uniform_real_distribution<float>(lo, hi)(rng);
+  };
+  const int width = Framebuffer::kTileSize;
+  // Уровень 4x4 и следующий за ним 2x2.
+  std::vector<uint32_t> texture(4 * 4 + 2 * 2);
+  for (uint32_t& texel : texture) texel = rng();
+
+  for (int trial = 0; trial < 100; ++trial) {
+    const SpanSetup setup = randomSetup(
+        rng, static_cast<LightingModel>(trial / 2 % 3),
+        static_cast<TextureFilter>(trial / 6 % 3),
+        trial % 2 ? texture.data() : nullptr, 4, 4);
+
+    std::vector<float> depth(width);
+    for (float& d : depth) d = uniform(0.0f, 1.0f) < 0.3f ? -1.0f : 1.0f;
+    std::vector<float> depthVisibility = depth, depthAvx = depth;
+    std::vector<uint32_t> forward(width, 0u);
+    std::vector<uint32_t> triangles(width, Framebuffer::kNoTriangle);
+    std::vector<uint32_t> trianglesAvx = triangles;
+    std::vector<float> weights[2], weightsAvx[2];
+    for (int k = 0; k < 2; ++k) {
+      weights[k].assign(width, 0.0f);
+      weightsAvx[k].assign(width, 0.0f);
+    }
+
+    RowSpan span;
+    span.xRef = -3;
+    span.xBegin = trial % 11;
+    span.xEnd = width - trial % 5;
+    span.b1 = uniform(0.0f, 1.0f);
+    span.b2 = uniform(0.0f, 1.0f);
+    span.triangle = 9u;
+    span.depth = depth.data();
+    span.color = forward.data();
+    shadeSpanScalar(setup, span);
+
+    span.depth = depthVisibility.data();
+    span.triangles = triangles.data();
+    span.weights[0] = weights[0].data();
+    span.weights[1] = weights[1].data();
+    const int written = writeVisibilityScalar(setup, span);
+    span.depth = depthAvx.data();
+    span.triangles = trianglesAvx.data();
+    span.weights[0] = weightsAvx[0].data();
+    span.weights[1] = weightsAvx[1].data();
+    ASSERT_EQ(written, writeVisibilityAvx2(setup, span)) << "trial " << trial;
+    ASSERT_EQ(depthVisibility, depth) << "trial " << trial;
+    ASSERT_EQ(depthAvx, depth) << "trial " << trial;
+    ASSERT_EQ(trianglesAvx, triangles) << "trial " << trial;
+    ASSERT_EQ(weightsAvx[0], weights[0]) << "trial " << trial;
+    ASSERT_EQ(weightsAvx[1], weights[1]) << "trial " << trial;
+
+    // Закраска по сохранённым весам даёт тот же цвет, что и прямая.
+    std::vector<uint32_t> deferred(width, 0u), deferredAvx(width, 0u);
+    shadePixelsScalar(setup, weights[0].data(), weights[1].data(),
+                      deferred.data(), width);
+    shadePixelsAvx2(setup, weights[0].data(), weights[1].data(),
+                    deferredAvx.data(), width - 3);
+    for (int x = 0; x < width; ++x) {
+      if (triangles[x] == Framebuffer::kNoTriangle) continue;
+      ASSERT_EQ(deferred[x], forward[x]) << "trial " << trial << " x " << x;
+    }
+    ASSERT_TRUE(std::equal(deferred.begin(), deferred.end() - 3,
+                           deferredAvx.begin()))
+        << "trial " << trial;
+    for (int x = width - 3; x < width; ++x) {
+      ASSERT_EQ(deferredAvx[x], 0u) << "trial " << trial;
+    }
+  }
+}
+
+TEST(SpanKernelTest, DepthPrepassMatchesForward) {
+  if (!cpuHasAvx2()) GTEST_SKIP() << "процессор без AVX2";
+
+  std::mt19937 rng(5);
+  auto uniform = [&](float lo, float hi) {
+    return std::uniform_real_distribution<float>(lo, hi)(rng);
+  };
+  const int width = Framebuffer::kTileSize;
+  constexpr int kTriangles = 5;
+
+  for (int trial = 0; trial < 150; ++trial) {
+    const DepthFormat format = static_cast<DepthFormat>(trial % 3);
+    SpanSetup setups[kTriangles];
+    RowSpan spans[kTriangles];
+    for (int i = 0; i < kTriangles; ++i) {
+      SpanSetup& setup = setups[i];
+      setup.db1dx = uniform(-0.05f, 0.05f);
+      setup.db2dx = uniform(-0.05f, 0.05f);
+      for (int k = 0; k < 3; ++k) setup.z[k] = uniform(-0.5f, 0.5f);
+      for (int c = 0; c < 3; ++c) {
+        setup.normal[c][0] = uniform(-1.0f, 1.0f);
+        setup.lightPosition[c] = uniform(-50.0f, 50.0f);
+        setup.ambient[c] = uniform(0.0f, 60.0f);
+        setup.diffuse[c] = uniform(0.0f, 300.0f);
+      }
+      spans[i].xRef = -2;
+      spans[i].xBegin = static_cast<int>(uniform(0.0f, width / 2));
+      spans[i].xEnd =
+          spans[i].xBegin + static_cast<int>(uniform(1.0f, width / 2));
+      spans[i].b1 = uniform(0.0f, 1.0f);
+      spans[i].b2 = uniform(0.0f, 1.0f);
+      spans[i].depthFormat = format;
+    }
+    // Последний треугольник — копия первого с другим цветом: при равной
+    // глубине пиксель остаётся первому.
+    setups[kTriangles - 1] = setups[0];
+    setups[kTriangles - 1].ambient[0] += 100.0f;
+    spans[kTriangles - 1] = spans[0];
+
+    const size_t depthBytes = Framebuffer::depthBytes(format);
+    std::vector<unsigned char> cleared(width * depthBytes);
+    for (int x = 0; x < width; ++x) {
+      const float far = 1.0f;
+      const uint32_t far24 = 0xFFFFFFu;
+      const uint16_t far16 = 0xFFFF;
+      void* d = &cleared[x * depthBytes];
+      if (format == DepthFormat::Float32) std::memcpy(d, &far, 4);
+      if (format == DepthFormat::Unorm24) std::memcpy(d, &far24, 4);
+      if (format == DepthFormat::Unorm16) std::memcpy(d, &far16, 2);
+    }
+
+    std::vector<unsigned char> depth = cleared;
+    std::vector<uint32_t> forward(width, 0u);
+    for (int i = 0; i < kTriangles; ++i) {
+      spans[i].depth = depth.data();
+      spans[i].color = forward.data();
+      shadeSpanScalar(setups[i], spans[i]);
+    }
+
+    // Предпроход в обратном порядке: глубина от порядка не зависит.
+    std::vector<unsigned char> prepass = cleared, prepassAvx = cleared;
+    for (int i = kTriangles - 1; i >= 0; --i) {
+      RowSpan span = spans[i];
+      span.depth = prepass.data();
+      const int written = writeDepthScalar(setups[i], span);
+      span.depth = prepassAvx.data();
+      ASSERT_EQ(writeDepthAvx2(setups[i], span), written) << "trial " << trial;
+    }
+    ASSERT_EQ(prepass, depth) << "trial " << trial;
+    ASSERT_EQ(prepassAvx, depth) << "trial " << trial;
+
+    std::vector<uint32_t> color(width, 0u), colorAvx(width, 0u);
+    for (int i = 0; i < kTriangles; ++i) {
+      RowSpan span = spans[i];
+      span.depth = prepass.data();
+      span.color = color.data();
+      const int written = shadeSpanEqualScalar(setups[i], span);
+      span.depth = prepassAvx.data();
+      span.color = colorAvx.data();
+      ASSERT_EQ(shadeSpanEqualAvx2(setups[i], span), written)
+          << "trial " << trial;
+    }
+    ASSERT_EQ(color, forward) << "trial " << trial;
+    ASSERT_EQ(colorAvx, forward) << "trial " << trial;
+  }
+}
+#endif
+
+TEST(SpanKernelTest, SpecializedKernelsMatchGeneric) {
+  // Ядра из таблицы собраны под операцию, формат глубины, освещение и
+  // текстуру; общие ядра выбирают то же по отрезку и setup на каждый вызов.
+  const ShadeSpanFn generic[] = {shadeSpanScalar, writeVisibilityScalar,
+                                 writeDepthScalar, shadeSpanEqualScalar};
+  const SpanOp ops[] = {SpanOp::Shade, SpanOp::Visibility, SpanOp::Depth,
+                        SpanOp::ShadeEqual};
+  const int width = Framebuffer::kTileSize;
+  const uint32_t texture[2 * 2] = {0xFF1EC80Au, 0xFF5A05FAu, 0x80504640u,
+                                   0xFF00FFFFu};
+
+  for (int op = 0; op < 4; ++op) {
+    for (int f = 0; f < 3; ++f) {
+      const DepthFormat format = static_cast<DepthFormat>(f);
+      for (int m = 0; m < 18; ++m) {
+        const LightingModel lighting = static_cast<LightingModel>(m / 6);
+        const TextureFilter filter = static_cast<TextureFilter>(m / 2 % 3);
+        const bool textured = m % 2;
+        const SpanKernels kernels =
+            bestSpanKernels(ops[op], format, lighting, filter);
+        SpanSetup setup;
+        setup.lighting = lighting;
+        setup.filter = filter;
+        setup.db1dx = 0.01f;
+        setup.db2dx = 0.005f;
+        const float z[3] = {-0.5f, 0.7f, -0.9f};
+        std::copy(z, z + 3, setup.z);
+        for (int c = 0; c < 3; ++c) {
+          setup.normal[c][0] = c == 2 ? 1.0f : 0.0f;
+          setup.world[c][1] = 1.0f;
+          setup.ambient[c] = 20.0f;
+          setup.diffuse[c] = 180.0f;
+          const float lit[3] = {40.0f + 50.0f * c, -30.0f, 12.0f};
+          std::copy(lit, lit + 3, setup.lit[c]);
+        }
+        setup.lightPosition[2] = 10.0f;
+        setup.invW[0] = 1.0f;
+        setup.uvw[0][1] = 1.0f;
+        setup.uvw[1][2] = 1.0f;
+        if (textured) {
+          setup.texture = texture;
+          setup.textureWidth = 2;
+          setup.textureHeight = 2;
+          // Вторым уровнем служит первый тексель.
+          setup.coarseTexture = texture;
+          setup.coarseWidth = 1;
+          setup.coarseHeight = 1;
+          setup.lodBlend = 77;
+        }
+
+        // Ядру на равенство нужна записанная глубина: сначала предпроход.
+        std::vector<unsigned char> depth(width *
+                                         Framebuffer::depthBytes(format));
+        std::vector<unsigned char> depthGeneric = depth;
+        std::vector<uint32_t> color(width), colorGeneric(width);
+        std::vector<uint32_t> triangles(width), trianglesGeneric(width);
+        std::vector<float> weights(2 * width), weightsGeneric(2 * width);
+        RowSpan span;
+        span.xBegin = 3;
+        span.xEnd = width - 5;
+        span.b1 = 0.1f;
+        span.b2 = 0.2f;
+        span.depthFormat = format;
+        span.triangle = 42;
+        auto run = [&](ShadeSpanFn kernel, std::vector<unsigned char>& d,
+                       std::vector<uint32_t>& c, std::vector<uint32_t>& t,
+                       std::vector<float>& w) {
+          std::fill(d.begin(), d.end(), 0xFF);
+          if (format == DepthFormat::Float32) {
+            std::fill_n(reinterpret_cast<float*>(d.data()), width, 1.0f);
+          } else if (format == DepthFormat::Unorm24) {
+            std::fill_n(reinterpret_cast<uint32_t*>(d.data()), width,
+                        0xFFFFFFu);
+          }
+          span.depth = d.data();
+          span.color = c.data();
+          span.triangles = t.data();
+          span.weights[0] = w.data();
+          span.weights[1] = w.data() + width;
+          if (ops[op] == SpanOp::ShadeEqual) writeDepthScalar(setup, span);
+          return kernel(setup, span);
+        };
+        const int written =
+            run(textured ? kernels.textured : kernels.plain, depth, color,
+                triangles, weights);
+        const int writtenGeneric = run(generic[op], depthGeneric,
+                                       colorGeneric, trianglesGeneric,
+                                       weightsGeneric);
+        SCOPED_TRACE(testing::Message() << "op " << op << " format " << f
+                                        << " lighting " << m / 6
+                                        << " filter " << m / 2 % 3
+                                        << " textured " << textured);
+        EXPECT_EQ(written, span.xEnd - span.xBegin);
+        EXPECT_EQ(written, writtenGeneric);
+        EXPECT_EQ(depth, depthGeneric);
+        EXPECT_EQ(color, colorGeneric);
+        EXPECT_EQ(triangles, trianglesGeneric);
+        EXPECT_EQ(weights, weightsGeneric);
+      }
+    }
+  }
+}
+
+namespace {
+// Растеризует треугольник так же, как RenderRasterize::drawTriangle: вершины
+// в фиксированной точке, любой обход, покрытие строки — через coveredSteps.
+// Прибавляет единицу к coverage каждого закрашенного пикселя.
+void coverTriangle(float x0, float y0, float x1, float y1, float x2, float y2,
+                   int width, int height, std::vector<int>& coverage) {
+  int64_t fx[3] = {toFixed(x0), toFixed(x1), toFixed(x2)};
+  int64_t fy[3] = {toFixed(y0), toFixed(y1), toFixed(y2)};
+  const int64_t area = (fx[1] - fx[0]) * (fy[2] - fy[0]) -
+                       (fy[1] - fy[0]) * (fx[2] - fx[0]);
+  if (area == 0) return;
+  if (area < 0) {
+    std::swap(fx[1], fx[2]);
+    std::swap(fy[1], fy[2]);
+  }
+  const PixelBounds px = pixelBounds(fx, fy, width, height);
+  if (px.empty()) return;
+  const EdgeFunction edge[3] = {EdgeFunction(fx[1], fy[1], fx[2], fy[2]),
+                                EdgeFunction(fx[2], fy[2], fx[0], fy[0]),
+                                EdgeFunction(fx[0], fy[0], fx[1], fy[1])};
+  const int64_t refX = (int64_t{px.minX} << kSubpixelBits) + kSubpixelHalf;
+  for (int y = px.minY; y <= px.maxY; ++y) {
+    const int64_t cy = (int64_t{y} << kSubpixelBits) + kSubpixelHalf;
+    int64_t lo = 0;
+    int64_t hi = px.maxX - px.minX + 1;
+    for (int k = 0; k < 3; k++) {
+      coveredSteps(edge[k].at(refX, cy), edge[k].stepX, lo, hi);
+    }
+    for (int64_t t = lo; t < hi; ++t) coverage[y * width + px.minX + t]++;
+  }
+}
+}  // namespace
+
+TEST(EdgeFunctionTest, SharedEdgeCoversEachPixelOnce) {
+  const int width = 61, height = 47;
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> inside(0.0f, 61.0f);
+  for (int run = 0; run < 200; ++run) {
+    // Четырёхугольник шире экрана, диагональ — через экран. Половину прогонов
+    // концы диагонали лежат точно в центрах пикселей: там и решает правило
+    // верхнего-левого ребра.
+    float ax = inside(rng), ay = -20.0f, bx = inside(rng), by = 70.0f;
+    if (run % 2) {
+      ax = std::floor(ax) + 0.5f;
+      bx = std::floor(bx) + 0.5f;
+      ay = -20.5f;
+      by = 70.5f;
+    }
+    std::vector<int> coverage(width * height, 0);
+    coverTriangle(-30.0f, -30.0f, ax, ay, bx, by, width, height, coverage);
+    coverTriangle(ax, ay, 90.0f, -30.0f, 90.0f, 80.0f, width, height,
+                  coverage);
+    coverTriangle(ax, ay, 90.0f, 80.0f, bx, by, width, height, coverage);
+    coverTriangle(-30.0f, -30.0f, bx, by, -30.0f, 80.0f, width, height,
+                  coverage);
+    SCOPED_TRACE(testing::Message() << "run " << run);
+    for (int i = 0; i < width * height; ++i) {
+      ASSERT_EQ(coverage[i], 1) << "pixel " << i % width << ", " << i / width;
+    }
+  }
+}
+
+TEST(EdgeFunctionTest, FanAroundVertexCoversEachPixelOnce) {
+  const int width = 53, height = 41;
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  for (int run = 0; run < 100; ++run) {
+    // Общая вершина внутри экрана, внешние — на окружности далеко за ним;
+    // углы между спицами меньше развёрнутого, веер замкнут, так что закрыт
+    // каждый пиксель. Вершина и углы
+    // через раз ложатся в центры пикселей и на диагонали.
+    float cx = 2.0f + unit(rng) * (width - 4);
+    float cy = 2.0f + unit(rng) * (height - 4);
+    if (run % 2) {
+      cx = std::floor(cx) + 0.5f;
+      cy = std::floor(cy) + 0.5f;
+    }
+    const int spokes = 4 + run % 9;
+    std::vector<float> angles(spokes);
+    for (int k = 0; k < spokes; ++k) {
+      angles[k] = run % 2 ? 6.2831853f * k / spokes
+                          : 6.2831853f * (k + 0.5f * unit(rng)) / spokes;
+    }
+    std::vector<int> coverage(width * height, 0);
+    const float radius = 400.0f;
+    for (int k = 0; k < spokes; ++k) {
+      const float a0 = angles[k];
+      const float a1 = angles[(k + 1) % spokes];
+      const float x0 = cx + radius * std::cos(a0);
+      const float y0 = cy + radius * std::sin(a0);
+      const float x1 = cx + radius * std::cos(a1);
+      const float y1 = cy + radius * std::sin(a1);
+      // Соседние треугольники веера — с разным обходом.
+      if (k % 2) {
+        coverTriangle(cx, cy, x0, y0, x1, y1, width, height, coverage);
+      } else {
+        coverTriangle(cx, cy, x1, y1, x0, y0, width, height, coverage);
+      }
+    }
+    SCOPED_TRACE(testing::Message() << "run " << run << " spokes " << spokes);
+    for (int i = 0; i < width * height; ++i) {
+      ASSERT_EQ(coverage[i], 1) << "pixel " << i % width << ", " << i / width;
+    }
+  }
+}
+
+TEST(EdgeFunctionTest, SpansMatchPerPixelTestInsideBounds) {
+  // coveredSteps даёт те же пиксели, что и значение ребра в каждом из них,
+  // и все они внутри pixelBounds — прямоугольника, по которому биннер
+  // раскладывает треугольник по плиткам.
+  const int width = 40, height = 30;
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> coord(-10.0f, 50.0f);
+  for (int run = 0; run < 500; ++run) {
+    float v[6];
+    for (float& c : v) c = coord(rng);
+    std::vector<int> coverage(width * height, 0);
+    coverTriangle(v[0], v[1], v[2], v[3], v[4], v[5], width, height,
+                  coverage);
+
+    int64_t fx[3] = {toFixed(v[0]), toFixed(v[2]), toFixed(v[4])};
+    int64_t fy[3] = {toFixed(v[1]), toFixed(v[3]), toFixed(v[5])};
+    const int64_t area = (fx[1] - fx[0]) * (fy[2] - fy[0]) -
+                         (fy[1] - fy[0]) * (fx[2] - fx[0]);
+    if (area < 0) {
+      std::swap(fx[1], fx[2]);
+      std::swap(fy[1], fy[2]);
+    }
+    const PixelBounds px = pixelBounds(fx, fy, width, height);
+    const EdgeFunction edge[3] = {EdgeFunction(fx[1], fy[1], fx[2], fy[2]),
+                                  EdgeFunction(fx[2], fy[2], fx[0], fy[0]),
+                                  EdgeFunction(fx[0], fy[0], fx[1], fy[1])};
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        const int64_t sx = (int64_t{x} << kSubpixelBits) + kSubpixelHalf;
+        const int64_t sy = (int64_t{y} << kSubpixelBits) + kSubpixelHalf;
+        const bool covered = area != 0 && edge[0].at(sx, sy) >= 0 &&
+                             edge[1].at(sx, sy) >= 0 &&
+                             edge[2].at(sx, sy) >= 0;
+        SCOPED_TRACE(testing::Message() << "run " << run << " pixel " << x
+                                        << ", " << y);
+        ASSERT_EQ(coverage[y * width + x], covered ? 1 : 0);
+        if (covered) {
+          ASSERT_TRUE(x >= px.minX && x <= px.maxX && y >= px.minY &&
+                      y <= px.maxY);
+        }
+      }
+    }
+  }
+}
+
+TEST(PolygonClipperTest, ClipsToNearPlaneAndGuardBand) {
+  // Атрибуты — линейные функции clip-координат, поэтому у новых вершин они
+  // должны совпасть с той же функцией от их позиции.
+  auto vertex = [](float x, float y, float z, float w) {
+    ClipVertex v;
+    v.clip = Vertex(x, y, z, w);
+    v.world = v.clip;
+    v.normal = Normal(x + w, y - w, 2.0f * z);
+    v.uv = UVCoordinate(x, y);
+    return v;
+  };
+  auto clip = [&](const ClipVertex& a, const ClipVertex& b,
+                  const ClipVertex& c, std::vector<ClipVertex>& out) {
+    ClipVertex polygon[2][kMaxClipVertices] = {{a, b, c}};
+    int count;
+    const ClipVertex* p = clipTriangle(polygon, count);
+    out.assign(p, p + std::max(count, 0));
+    return count;
+  };
+  std::vector<ClipVertex> out;
+
+  // Целиком внутри — без изменений.
+  EXPECT_EQ(clip(vertex(0, 0, 0, 1), vertex(0.5f, 0, 0, 1),
+                 vertex(0, 0.5f, 0.5f, 1), out),
+            3);
+  EXPECT_EQ(out[1].clip, Vertex(0.5f, 0, 0, 1));
+
+  // Целиком за ближней плоскостью — отсечён.
+  EXPECT_LT(clip(vertex(0, 0, -3, 1), vertex(1, 0, -3, 1),
+                 vertex(0, 1, -2, 1), out),
+            3);
+
+  // Одна вершина за камерой (w < 0): ближняя плоскость делает четырёхугольник.
+  EXPECT_EQ(clip(vertex(0, 0, 0, 1), vertex(0.5f, 0, 0, 1),
+                 vertex(0, 0, -2, -1), out),
+            4);
+  // Вылезает за защитную полосу по x и y: срезаются оба угла.
+  std::vector<ClipVertex> guard;
+  EXPECT_EQ(clip(vertex(-1, -1, 0, 1), vertex(6, -1, 0, 1), vertex(-1, 6, 0, 1),
+                 guard),
+            5);
+  out.insert(out.end(), guard.begin(), guard.end());
+  for (const ClipVertex& v : out) {
+    for (int plane = 0; plane < kClipPlanes; ++plane) {
+      EXPECT_GE(planeDistance(v.clip, plane), -1e-5f) << "plane " << plane;
+    }
+    EXPECT_LT((v.world - v.clip).norm(), 1e-5f);
+    EXPECT_LT((v.uv - v.clip.head<2>()).norm(), 1e-5f);
+    const Normal n(v.clip.x() + v.clip.w(), v.clip.y() - v.clip.w(),
+                   2.0f * v.clip.z());
+    EXPECT_LT((v.normal - n).norm(), 1e-5f);
+  }
+}